@@ -0,0 +1,73 @@
+#ifndef HISTOGRAM_CATALOG_HPP
+#define HISTOGRAM_CATALOG_HPP
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "TFile.h"
+#include "TH1.h"
+#include "TKey.h"
+#include "TList.h"
+
+// Histograms of a generated file, looked up by name. Only the list of keys is
+// read when the catalog is created: a histogram is read the first time it is
+// asked for, so the histograms and trees an analysis does not use are never
+// loaded.
+//
+// Rebinned versions are cached too, so several fits of the same rebinned
+// histogram rebin it only once, and the histogram as read from the file is
+// never modified. Like those read with TFile::Get, all the histograms belong to
+// the file and are deleted when it is closed. The catalog is not thread safe,
+// so the histograms must be looked up before any thread uses them.
+class HistogramCatalog {
+ public:
+  HistogramCatalog(TFile* file) : m_file{file} {
+    auto key_list = m_file->GetListOfKeys();
+
+    for (int i{}; i < key_list->GetSize(); ++i) {
+      m_names.insert(static_cast<TKey*>(key_list->At(i))->GetName());
+    }
+  }
+
+  bool has(std::string const& name) const { return m_names.count(name) > 0; }
+
+  // Returns the histogram name merging n_rebin bins into one, nullptr if the
+  // file does not hold it
+  TH1* get(std::string const& name, int n_rebin = 1) {
+    auto cached = m_histograms.find({name, n_rebin});
+
+    if (cached != m_histograms.end()) {
+      return cached->second;
+    }
+
+    if (!has(name)) {
+      return nullptr;
+    }
+
+    TH1* histogram{nullptr};
+
+    if (n_rebin == 1) {
+      m_file->GetObject(name.c_str(), histogram);
+    } else if (auto original = get(name)) {
+      auto rebinned_name = name + "_rebin" + std::to_string(n_rebin);
+
+      histogram = original->Rebin(n_rebin, rebinned_name.c_str());
+      histogram->SetDirectory(m_file);
+    }
+
+    m_histograms[{name, n_rebin}] = histogram;
+
+    return histogram;
+  }
+
+ private:
+  TFile* m_file;
+  std::set<std::string> m_names;
+
+  // histograms read or rebinned so far, by name and number of merged bins
+  std::map<std::pair<std::string, int>, TH1*> m_histograms;
+};
+
+#endif
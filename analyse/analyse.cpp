@@ -1,11 +1,21 @@
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "HistogramCatalog.hpp"
+#include "Math/MinimizerOptions.h"
 #include "TCanvas.h"
 #include "TF1.h"
 #include "TFile.h"
 #include "TH1.h"
-#include "TKey.h"
 #include "TMath.h"
 #include "TROOT.h"
 #include "TStyle.h"
@@ -13,6 +23,20 @@
 const char* PARTICLE_NAMES[7]{"pion+",   "pion-",   "kaon+", "kaon-",
                               "proton+", "proton-", "K*"};
 
+// Histograms written by the generation, which the analysis reads
+const char* HISTOGRAM_NAMES[12]{"particle_types_h",
+                                "azimutal_angles_h",
+                                "polar_angles_h",
+                                "momentum_h",
+                                "momentum_xy_h",
+                                "energy_h",
+                                "invm_all_h",
+                                "invm_opposite_charge_h",
+                                "invm_same_charge_h",
+                                "invm_pion_kaon_opposite_h",
+                                "invm_pion_kaon_same_h",
+                                "invm_decayed_h"};
+
 // Labels for fit parameters
 const char* HEIGHT_LABEL = "Height (p0)";
 const char* MEAN_LABEL = "Mean (p1)";
@@ -38,6 +62,130 @@ Double_t exp(Double_t* xx, Double_t* par) {
 
 Double_t uniform(Double_t* xx, Double_t* par) { return par[0]; }
 
+// Labels of the fit parameters, in the order every fit function takes them
+const char* PARAMETER_LABELS[3]{HEIGHT_LABEL, MEAN_LABEL, STDDEV_LABEL};
+
+// Fit of a histogram, independent from the other fits of the analysis
+struct FitJob {
+  TH1* histogram;
+  TF1* function;
+};
+
+// Fits run by the analysis, in the order of FitJobs
+enum FitIndex {
+  AZIMUTAL_FIT,
+  POLAR_FIT,
+  MOMENTUM_FIT,
+  K_STAR_FIT,
+  INVM_ALL_FIT,
+  INVM_PION_KAON_FIT,
+  N_FITS
+};
+
+using FitJobs = std::array<FitJob, N_FITS>;
+
+/**
+ * Helper function to check that a file holds all the histograms of the
+ * analysis, without reading them.
+ */
+bool hasHistograms(HistogramCatalog const& catalog, const char* file_name) {
+  for (auto name : HISTOGRAM_NAMES) {
+    if (!catalog.has(name)) {
+      std::cout << "ERROR: " << file_name << " does not hold " << name << "!"
+                << '\n';
+
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Helper function to create a fit function over [low, high] with the given
+ * starting parameters, named after PARAMETER_LABELS.
+ */
+TF1* createFit(const char* name, Double_t (*function)(Double_t*, Double_t*),
+               double low, double high,
+               std::vector<double> const& parameters) {
+  TF1* fit = new TF1(name, function, low, high, parameters.size());
+
+  for (int i{}; i < (int)parameters.size(); ++i) {
+    fit->SetParameter(i, parameters[i]);
+    fit->SetParName(i, PARAMETER_LABELS[i]);
+  }
+
+  return fit;
+}
+
+/**
+ * Helper function to find the signal by subtracting the same charge histogram
+ * from the opposite charge one. Both are rebinned in order to have wider bins.
+ * The subtraction does not belong to the file, it is owned by the caller.
+ */
+TH1F* createSubtraction(HistogramCatalog& catalog,
+                        const char* opposite_charge_name,
+                        const char* same_charge_name, const char* name,
+                        const char* title) {
+  auto opposite_charge_h = catalog.get(opposite_charge_name, 10);
+  auto same_charge_h = catalog.get(same_charge_name, 10);
+  TH1F* subtraction = new TH1F(*(TH1F*)opposite_charge_h);
+  subtraction->SetDirectory(nullptr);
+  // Cosmetics
+  subtraction->SetTitle(title);
+  subtraction->SetName(name);
+  subtraction->SetXTitle("Invariant mass (GeV)");
+  subtraction->SetYTitle("Occurrences");
+  subtraction->Add(opposite_charge_h, same_charge_h, 1, -1);
+  subtraction->SetEntries(opposite_charge_h->GetEntries());
+  subtraction->SetAxisRange(H_LOW, H_HIGH);
+
+  return subtraction;
+}
+
+/**
+ * Helper function to prepare the histograms of the analysis and the functions
+ * fitting them. The fits do not depend on each other, so they can run in any
+ * order.
+ */
+FitJobs createFitJobs(HistogramCatalog& catalog) {
+  FitJobs jobs{};
+
+  jobs[AZIMUTAL_FIT] = {
+      catalog.get("azimutal_angles_h"),
+      createFit("azimutal_fit", uniform, 0., TMath::Pi(), {10000})};
+  jobs[POLAR_FIT] = {
+      catalog.get("polar_angles_h"),
+      createFit("polar_fit", uniform, 0., TMath::TwoPi(), {10000})};
+  jobs[MOMENTUM_FIT] = {
+      catalog.get("momentum_h"),
+      createFit("momentum_fit", exp, 0., 9., {90000, 1.})};
+
+  // Rebin in order to have wider bins
+  auto invm_decayed_h = catalog.get("invm_decayed_h", 5);
+  invm_decayed_h->SetAxisRange(H_LOW, H_HIGH);
+  jobs[K_STAR_FIT] = {
+      invm_decayed_h,
+      createFit("k_star_fit", gauss, H_LOW, H_HIGH, {500, 0.9, 0.05})};
+
+  jobs[INVM_ALL_FIT] = {
+      createSubtraction(catalog, "invm_opposite_charge_h",
+                        "invm_same_charge_h", "invm_subtraction_all",
+                        "Opposite charge - same charge"),
+      createFit("invm_all_fit", gauss, H_LOW, H_HIGH,
+                {7.996, 0.8919, 0.04989})};
+
+  // Subtract kaon & pion with same charge from kaon & pion with opposite charge
+  jobs[INVM_PION_KAON_FIT] = {
+      createSubtraction(catalog, "invm_pion_kaon_opposite_h",
+                        "invm_pion_kaon_same_h", "invm_subtraction_pion_kaon",
+                        "Opposite charge - same charge (kaon & pion)"),
+      createFit("invm_pion_kaon_fit", gauss, H_LOW, H_HIGH,
+                {7.996, 0.8919, 0.04989})};
+
+  return jobs;
+}
+
 void analyse(const char* file_name) {
   // Set histogram options. Show entries, parameters, errors and chi square/DOF
   gStyle->SetOptFit(001);
@@ -45,14 +193,11 @@ void analyse(const char* file_name) {
 
   TFile* file = new TFile(file_name, "READ");
 
-  std::array<TH1*, 12> histo_array;
-
-  // Read histograms from TList and put them inside an array
-  auto key_list = file->GetListOfKeys();
+  // Histograms are read by name, when they are first needed
+  HistogramCatalog catalog{file};
 
-  for (int i{}; i < 12; ++i) {
-    auto key = (TKey*)key_list->At(i);
-    histo_array[i] = (TH1*)file->Get(key->GetName());
+  if (!hasHistograms(catalog, file_name)) {
+    return;
   }
 
   std::array<double, 12> expected_entries{
@@ -62,14 +207,15 @@ void analyse(const char* file_name) {
   std::cout << "ENTRIES" << '\n';
 
   for (int i{}; i < 12; ++i) {
-    auto title = histo_array[i]->GetTitle();
-    auto entries = histo_array[i]->GetEntries();
+    auto histogram = catalog.get(HISTOGRAM_NAMES[i]);
+    auto title = histogram->GetTitle();
+    auto entries = histogram->GetEntries();
 
     std::cout << title << ": expected " << expected_entries[i] << ", got "
               << entries << '\n';
   }
 
-  auto particle_types_histogram = histo_array[0];
+  auto particle_types_histogram = catalog.get("particle_types_h");
 
   // Print generated occurrences
   std::cout << "\nPARTICLE OCCURRENCES" << '\n';
@@ -96,13 +242,14 @@ void analyse(const char* file_name) {
   particle_types_histogram->SetYTitle("Occurrences");
   particle_types_histogram->Draw();
 
+  // Prepare the histograms to fit and the fit functions
+  auto jobs = createFitJobs(catalog);
+
   // Add and fit azimutal angles histogram
-  TF1* azimutal_fit = new TF1("azimutal_fit", uniform, 0., TMath::Pi(), 1);
-  azimutal_fit->SetParameter(0, 10000);
-  azimutal_fit->SetParName(0, HEIGHT_LABEL);
+  TF1* azimutal_fit = jobs[AZIMUTAL_FIT].function;
 
   particles_canvas->cd(2);
-  auto azimutal_angles_histogram = histo_array[1];
+  auto azimutal_angles_histogram = jobs[AZIMUTAL_FIT].histogram;
   azimutal_angles_histogram->SetXTitle("Azimutal angle (rad)");
   azimutal_angles_histogram->SetYTitle("Occurrences");
   azimutal_angles_histogram->Fit(azimutal_fit, "Q");
@@ -115,12 +262,10 @@ void analyse(const char* file_name) {
             << "Probability: " << azimutal_fit->GetProb() << '\n';
 
   // Add and fit polar angles histogram
-  TF1* polar_fit = new TF1("polar_fit", uniform, 0., TMath::TwoPi(), 1);
-  polar_fit->SetParameter(0, 10000);
-  polar_fit->SetParName(0, HEIGHT_LABEL);
+  TF1* polar_fit = jobs[POLAR_FIT].function;
 
   particles_canvas->cd(3);
-  auto polar_angles_histogram = histo_array[2];
+  auto polar_angles_histogram = jobs[POLAR_FIT].histogram;
   polar_angles_histogram->SetXTitle("Polar angle (rad)");
   polar_angles_histogram->SetYTitle("Occurrences");
   polar_angles_histogram->Fit(polar_fit, "Q");
@@ -133,14 +278,10 @@ void analyse(const char* file_name) {
             << "Probability: " << polar_fit->GetProb() << '\n';
 
   // Add and fit momentum histogram
-  TF1* momentum_fit = new TF1("momentum_fit", exp, 0., 9., 2);
-  momentum_fit->SetParameter(0, 90000);
-  momentum_fit->SetParName(0, HEIGHT_LABEL);
-  momentum_fit->SetParameter(1, 1.);
-  momentum_fit->SetParName(1, MEAN_LABEL);
+  TF1* momentum_fit = jobs[MOMENTUM_FIT].function;
 
   particles_canvas->cd(4);
-  auto momentum_histogram = histo_array[3];
+  auto momentum_histogram = jobs[MOMENTUM_FIT].histogram;
   momentum_histogram->SetXTitle("Momentum (GeV)");
   momentum_histogram->SetYTitle("Occurrences");
   momentum_histogram->Fit(momentum_fit, "Q");
@@ -160,48 +301,19 @@ void analyse(const char* file_name) {
   inv_mass_canvas->cd(1);
 
   // Add first histogram directly from the generation
-  TF1* k_star_fit = new TF1("k_star_fit", gauss, H_LOW, H_HIGH, 3);
-  k_star_fit->SetParameter(0, 500);
-  k_star_fit->SetParName(0, HEIGHT_LABEL);
-  k_star_fit->SetParameter(1, 0.9);
-  k_star_fit->SetParName(1, MEAN_LABEL);
-  k_star_fit->SetParameter(2, 0.05);
-  k_star_fit->SetParName(2, STDDEV_LABEL);
-  auto invm_decayed_h = histo_array[11];
-  // Rebin in order to have wider bins
-  invm_decayed_h->Rebin(5);
-  invm_decayed_h->SetAxisRange(H_LOW, H_HIGH);
+  TF1* k_star_fit = jobs[K_STAR_FIT].function;
+  auto invm_decayed_h = jobs[K_STAR_FIT].histogram;
   invm_decayed_h->SetTitle("Decay products");
   invm_decayed_h->SetXTitle("Invariant mass (GeV)");
   invm_decayed_h->SetYTitle("Occurrences");
   invm_decayed_h->Fit(k_star_fit, "Q");
 
-  // Create second histogram. Find the signal by subtracting same charge
+  // Add second histogram, with the signal found by subtracting same charge
   // particles from opposite charge particles
-  auto invm_opposite_charge_h = histo_array[7];
-  invm_opposite_charge_h->Rebin(10);
-  auto invm_same_charge_h = histo_array[8];
-  invm_same_charge_h->Rebin(10);
-  TH1F* invm_subtraction_all = new TH1F(*(TH1F*)invm_opposite_charge_h);
-  // Cosmetics
-  invm_subtraction_all->SetTitle("Opposite charge - same charge");
-  invm_subtraction_all->SetName("invm_subtraction_all");
-  invm_subtraction_all->SetXTitle("Invariant mass (GeV)");
-  invm_subtraction_all->SetYTitle("Occurrences");
-  invm_subtraction_all->Add(invm_opposite_charge_h, invm_same_charge_h, 1, -1);
-  invm_subtraction_all->SetEntries(invm_opposite_charge_h->GetEntries());
-  invm_subtraction_all->SetAxisRange(H_LOW, H_HIGH);
-
-  TF1* invm_all_fit = new TF1("invm_all_fit", gauss, H_LOW, H_HIGH, 3);
-  invm_all_fit->SetParameter(0, 7.996);
-  invm_all_fit->SetParName(0, HEIGHT_LABEL);
-  invm_all_fit->SetParameter(1, 0.8919);
-  invm_all_fit->SetParName(1, MEAN_LABEL);
-  invm_all_fit->SetParameter(2, 0.04989);
-  invm_all_fit->SetParName(2, STDDEV_LABEL);
+  TF1* invm_all_fit = jobs[INVM_ALL_FIT].function;
 
   inv_mass_canvas->cd(2);
-  invm_subtraction_all->Fit(invm_all_fit, "Q");
+  jobs[INVM_ALL_FIT].histogram->Fit(invm_all_fit, "Q");
 
   std::cout << "\nINVARIANT MASS BETWEEN ALL PARTICLES (OPPOSITE CHARGE - SAME "
                "CHARGE) FIT"
@@ -220,37 +332,12 @@ void analyse(const char* file_name) {
             << "K* width: " << invm_all_fit->GetParameter(2) << " +- "
             << invm_all_fit->GetParError(2) << '\n';
 
-  // Create the third histogram. Find the signal by subtracting kaon & pion with
-  // same charge from kaon & pion with opposite charge
-  auto invm_pion_kaon_opposite_h = histo_array[9];
-  invm_pion_kaon_opposite_h->Rebin(10);
-  auto invm_pion_kaon_same_h = histo_array[10];
-  invm_pion_kaon_same_h->Rebin(10);
-  TH1F* invm_subtraction_pion_kaon =
-      new TH1F(*(TH1F*)invm_pion_kaon_opposite_h);
-  // Cosmetics
-  invm_subtraction_pion_kaon->SetTitle(
-      "Opposite charge - same charge (kaon & pion)");
-  invm_subtraction_pion_kaon->SetName("invm_subtraction_pion_kaon");
-  invm_subtraction_pion_kaon->SetXTitle("Invariant mass (GeV)");
-  invm_subtraction_pion_kaon->SetYTitle("Occurrences");
-  invm_subtraction_pion_kaon->Add(invm_pion_kaon_opposite_h,
-                                  invm_pion_kaon_same_h, 1, -1);
-  invm_subtraction_pion_kaon->SetEntries(
-      invm_pion_kaon_opposite_h->GetEntries());
-  invm_subtraction_pion_kaon->SetAxisRange(H_LOW, H_HIGH);
-
-  TF1* invm_pion_kaon_fit =
-      new TF1("invm_pion_kaon_fit", gauss, H_LOW, H_HIGH, 3);
-  invm_pion_kaon_fit->SetParameter(0, 7.996);
-  invm_pion_kaon_fit->SetParName(0, HEIGHT_LABEL);
-  invm_pion_kaon_fit->SetParameter(1, 0.8919);
-  invm_pion_kaon_fit->SetParName(1, MEAN_LABEL);
-  invm_pion_kaon_fit->SetParameter(2, 0.04989);
-  invm_pion_kaon_fit->SetParName(2, STDDEV_LABEL);
+  // Add the third histogram, with the signal found by subtracting kaon & pion
+  // with same charge from kaon & pion with opposite charge
+  TF1* invm_pion_kaon_fit = jobs[INVM_PION_KAON_FIT].function;
 
   inv_mass_canvas->cd(3);
-  invm_subtraction_pion_kaon->Fit(invm_pion_kaon_fit, "Q");
+  jobs[INVM_PION_KAON_FIT].histogram->Fit(invm_pion_kaon_fit, "Q");
 
   std::cout << "\nINVARIANT MASS BETWEEN KAON AND PION (OPPOSITE CHARGE - SAME "
                "CHARGE) FIT"
@@ -269,4 +356,185 @@ void analyse(const char* file_name) {
             << invm_pion_kaon_fit->GetParError(1) << '\n'
             << "K* width: " << invm_pion_kaon_fit->GetParameter(2) << " +- "
             << invm_pion_kaon_fit->GetParError(2) << '\n';
-}
\ No newline at end of file
+}
+
+/**
+ * Helper function to write a number as JSON, where infinities and NaN, as a
+ * chi square over no degrees of freedom, have no representation.
+ */
+void writeJsonNumber(std::ostream& out, double value) {
+  if (std::isfinite(value)) {
+    out << value;
+  } else {
+    out << "null";
+  }
+}
+
+/**
+ * Helper function to write a string as JSON, between quotes and with the
+ * quotes, the backslashes and the control characters escaped.
+ */
+void writeJsonString(std::ostream& out, const char* value) {
+  out << '"';
+
+  for (const char* c = value; *c != '\0'; ++c) {
+    if (*c == '"' || *c == '\\') {
+      out << '\\' << *c;
+    } else if (static_cast<unsigned char>(*c) < 0x20) {
+      char escaped[7];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x",
+                    static_cast<unsigned char>(*c));
+      out << escaped;
+    } else {
+      out << *c;
+    }
+  }
+
+  out << '"';
+}
+
+/**
+ * Helper function to write the entries, the particle occurrences and the fit
+ * results of a file as a JSON object.
+ */
+void writeJson(std::ostream& out, const char* file_name,
+               HistogramCatalog& catalog, FitJobs const& jobs,
+               std::array<int, N_FITS> const& fit_status) {
+  out.precision(std::numeric_limits<double>::max_digits10);
+
+  out << "{\n  \"file\": ";
+  writeJsonString(out, file_name);
+  out << ",\n  \"entries\": {";
+
+  for (int i{}; i < 12; ++i) {
+    out << (i == 0 ? "\n" : ",\n") << "    ";
+    writeJsonString(out, HISTOGRAM_NAMES[i]);
+    out << ": " << catalog.get(HISTOGRAM_NAMES[i])->GetEntries();
+  }
+
+  out << "\n  },\n  \"occurrences\": {";
+
+  for (int i{}; i < 7; ++i) {
+    out << (i == 0 ? "\n" : ",\n") << "    ";
+    writeJsonString(out, PARTICLE_NAMES[i]);
+    out << ": " << catalog.get("particle_types_h")->GetBinContent(i + 1);
+  }
+
+  out << "\n  },\n  \"fits\": [";
+
+  for (int i{}; i < N_FITS; ++i) {
+    auto fit = jobs[i].function;
+
+    out << (i == 0 ? "\n" : ",\n") << "    {\n      \"name\": ";
+    writeJsonString(out, fit->GetName());
+    out << ",\n      \"histogram\": ";
+    writeJsonString(out, jobs[i].histogram->GetName());
+    out << ",\n      \"status\": " << fit_status[i]
+        << ",\n      \"parameters\": [";
+
+    for (int p{}; p < fit->GetNpar(); ++p) {
+      out << (p == 0 ? "\n" : ",\n") << "        {\"name\": ";
+      writeJsonString(out, fit->GetParName(p));
+      out << ", \"value\": ";
+      writeJsonNumber(out, fit->GetParameter(p));
+      out << ", \"error\": ";
+      writeJsonNumber(out, fit->GetParError(p));
+      out << "}";
+    }
+
+    out << "\n      ],\n      \"chi_square_ndf\": ";
+    writeJsonNumber(out, fit->GetChisquare() / fit->GetNDF());
+    out << ",\n      \"probability\": ";
+    writeJsonNumber(out, fit->GetProb());
+    out << "\n    }";
+  }
+
+  out << "\n  ]\n}\n";
+}
+
+/**
+ * Non-interactive version of analyse, for analysing many files in a row. No
+ * canvas is created: the fits run concurrently on n_threads threads (one per
+ * core if n_threads is 0) and their results are written as JSON to
+ * output_file_name, or to the standard output if it is null.
+ */
+void analyseBatch(const char* file_name, const char* output_file_name = nullptr,
+                  int n_threads = 0) {
+  if (n_threads < 1) {
+    n_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  n_threads = std::min<int>(n_threads, N_FITS);
+
+  TFile* file = TFile::Open(file_name, "READ");
+
+  if (!file || file->IsZombie()) {
+    std::cout << "ERROR: Could not open " << file_name << "!" << '\n';
+    return;
+  }
+
+  HistogramCatalog catalog{file};
+
+  if (!hasHistograms(catalog, file_name)) {
+    file->Close();
+    delete file;
+    return;
+  }
+
+  // The histograms and the functions are created here, so that the threads
+  // only fit them
+  auto jobs = createFitJobs(catalog);
+  std::array<int, N_FITS> fit_status{};
+
+  if (n_threads > 1) {
+    ROOT::EnableThreadSafety();
+  }
+
+  // TMinuit, the default minimizer, is not thread safe. Minuit2 is used with
+  // any number of threads, so that the results do not depend on it, and the
+  // previous default is restored for the rest of the session
+  std::string default_minimizer =
+      ROOT::Math::MinimizerOptions::DefaultMinimizerType();
+  ROOT::Math::MinimizerOptions::SetDefaultMinimizer("Minuit2");
+
+  std::atomic<int> next_job{0};
+  std::vector<std::thread> threads{};
+
+  for (int t{}; t < n_threads; ++t) {
+    threads.emplace_back([&] {
+      for (int i = next_job++; i < N_FITS; i = next_job++) {
+        // Fit without drawing and without storing the function in the
+        // histogram, which would be shared between the threads
+        fit_status[i] = jobs[i].histogram->Fit(jobs[i].function, "Q0N");
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ROOT::Math::MinimizerOptions::SetDefaultMinimizer(default_minimizer.c_str());
+
+  if (output_file_name == nullptr) {
+    writeJson(std::cout, file_name, catalog, jobs, fit_status);
+  } else {
+    std::ofstream output{output_file_name};
+    writeJson(output, file_name, catalog, jobs, fit_status);
+
+    if (!output) {
+      std::cout << "ERROR: Could not write " << output_file_name << "!"
+                << '\n';
+    }
+  }
+
+  for (auto& job : jobs) {
+    delete job.function;
+  }
+
+  delete jobs[INVM_ALL_FIT].histogram;
+  delete jobs[INVM_PION_KAON_FIT].histogram;
+
+  file->Close();
+  delete file;
+}
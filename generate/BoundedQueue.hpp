@@ -0,0 +1,95 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/**
+ * Thread-safe FIFO queue with a maximum size, used to hand work from the
+ * generation threads to a background thread. push blocks while the queue is
+ * full, so a slow consumer limits the memory used instead of growing it. Once
+ * closed, pop returns the remaining items and then std::nullopt. The items are
+ * kept in a ring of capacity slots allocated up front, so pushing and popping
+ * never allocate; T has to be default constructible.
+ */
+template <class T>
+class BoundedQueue {
+ public:
+  BoundedQueue(int capacity) : m_capacity{capacity}, m_items(capacity) {}
+
+  void push(T item) {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_not_full.wait(lock, [this] { return m_size < m_capacity; });
+
+    m_items[(m_first + m_size) % m_capacity] = std::move(item);
+    ++m_size;
+    m_not_empty.notify_one();
+  }
+
+  // like push, but returns false, dropping the item, instead of waiting when
+  // the queue is full
+  bool tryPush(T item) {
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    if (m_size == m_capacity) {
+      return false;
+    }
+
+    m_items[(m_first + m_size) % m_capacity] = std::move(item);
+    ++m_size;
+    m_not_empty.notify_one();
+
+    return true;
+  }
+
+  std::optional<T> pop() {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_not_empty.wait(lock, [this] { return m_size > 0 || m_closed; });
+
+    return mTakeFirst();
+  }
+
+  // like pop, but returns std::nullopt instead of waiting when the queue is
+  // empty
+  std::optional<T> tryPop() {
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    return mTakeFirst();
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_closed = true;
+    m_not_empty.notify_all();
+  }
+
+ private:
+  int const m_capacity;
+  bool m_closed{false};
+
+  std::vector<T> m_items;
+  int m_first{};
+  int m_size{};
+  std::mutex m_mutex;
+  std::condition_variable m_not_full;
+  std::condition_variable m_not_empty;
+
+  // called with the mutex locked
+  std::optional<T> mTakeFirst() {
+    if (m_size == 0) {
+      return std::nullopt;
+    }
+
+    std::optional<T> item{std::move(m_items[m_first])};
+    m_first = (m_first + 1) % m_capacity;
+    --m_size;
+    m_not_full.notify_one();
+
+    return item;
+  }
+};
+
+#endif
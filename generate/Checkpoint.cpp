@@ -0,0 +1,287 @@
+#include "Checkpoint.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "EventMixer.hpp"
+#include "RandomEngine.hpp"
+#include "SpeciesSampler.hpp"
+#include "TH1.h"
+#include "TList.h"
+#include "generate.hpp"
+
+/**
+ * Archive appending the values passed to it to a string of bytes. Saving and
+ * restoring go through the same serialize functions, with this archive and
+ * with InputArchive, so the two always handle the values in the same order.
+ */
+class OutputArchive {
+ public:
+  static constexpr bool loading = false;
+
+  OutputArchive(std::string& data) : m_data{data} {}
+
+  template <class T>
+  void operator()(T const* values, int n) {
+    m_data.append(reinterpret_cast<char const*>(values), n * sizeof(T));
+  }
+
+  template <class T>
+  void operator()(std::vector<T>& values) {
+    int n = values.size();
+
+    (*this)(&n, 1);
+    (*this)(values.data(), n);
+  }
+
+ private:
+  std::string& m_data;
+};
+
+/**
+ * Archive reading back the values written by OutputArchive. Reading past the
+ * end of the data leaves the values untouched and marks the archive as failed.
+ */
+class InputArchive {
+ public:
+  static constexpr bool loading = true;
+
+  InputArchive(std::string const& data) : m_data{data} {}
+
+  template <class T>
+  void operator()(T* values, int n) {
+    std::size_t bytes = n * sizeof(T);
+
+    if (!m_ok || n < 0 || m_position + bytes > m_data.size()) {
+      m_ok = false;
+      return;
+    }
+
+    if (bytes == 0) {
+      return;
+    }
+
+    std::memcpy(values, m_data.data() + m_position, bytes);
+    m_position += bytes;
+  }
+
+  template <class T>
+  void operator()(std::vector<T>& values) {
+    int n{-1};
+
+    (*this)(&n, 1);
+
+    if (m_ok && n >= 0 && n * sizeof(T) <= m_data.size() - m_position) {
+      values.resize(n);
+      (*this)(values.data(), n);
+    } else {
+      m_ok = false;
+    }
+  }
+
+  bool ok() const { return m_ok; }
+
+ private:
+  std::string const& m_data;
+  std::size_t m_position{};
+  bool m_ok{true};
+};
+
+/**
+ * Helper function to save or restore the content, errors and statistics of a
+ * TH1 through an archive.
+ */
+template <class Archive>
+void serializeHistogram(Archive& archive, TH1* histogram) {
+  int n_bins = histogram->GetNbinsX() + 2;
+  bool has_sumw2 = histogram->GetSumw2N() > 0;
+  auto sumw2 = histogram->GetSumw2();
+
+  std::vector<double> contents(n_bins);
+  std::vector<double> errors(has_sumw2 ? n_bins : 0);
+  double stats[4]{};
+  double entries{};
+
+  if constexpr (!Archive::loading) {
+    for (int bin{}; bin < n_bins; ++bin) {
+      contents[bin] = histogram->GetBinContent(bin);
+
+      if (has_sumw2) {
+        errors[bin] = (*sumw2)[bin];
+      }
+    }
+
+    histogram->GetStats(stats);
+    entries = histogram->GetEntries();
+  }
+
+  archive(contents.data(), contents.size());
+  archive(errors.data(), errors.size());
+  archive(stats, 4);
+  archive(&entries, 1);
+
+  if constexpr (Archive::loading) {
+    for (int bin{}; bin < n_bins; ++bin) {
+      histogram->SetBinContent(bin, contents[bin]);
+
+      if (has_sumw2) {
+        (*sumw2)[bin] = errors[bin];
+      }
+    }
+
+    // like in Histogram::copyTo, the statistics are restored last
+    histogram->PutStats(stats);
+    histogram->SetEntries(entries);
+  }
+}
+
+/**
+ * Helper function to save or restore the state of a generation thread through
+ * an archive, after the header.
+ */
+template <class Archive>
+void serializeThread(Archive& archive, int& n_events_done, RandomEngine& rng,
+                     GenerationHistograms& histograms, EventMixer* mixer) {
+  archive(&n_events_done, 1);
+  rng.serialize(archive);
+
+  for (int h{}; h < histograms.histo_list->GetSize(); ++h) {
+    serializeHistogram(archive,
+                       static_cast<TH1*>(histograms.histo_list->At(h)));
+  }
+
+  histograms.invm_all.serialize(archive);
+  histograms.invm_opposite_charge.serialize(archive);
+  histograms.invm_same_charge.serialize(archive);
+  histograms.invm_pion_kaon_opposite.serialize(archive);
+  histograms.invm_pion_kaon_same.serialize(archive);
+
+  // the mixed accumulators are only filled when the events are mixed
+  if (mixer != nullptr) {
+    histograms.invm_mixed_opposite_charge.serialize(archive);
+    histograms.invm_mixed_pion_kaon_opposite.serialize(archive);
+    mixer->serialize(archive);
+  }
+}
+
+bool CheckpointHeader::operator==(CheckpointHeader const& other) const {
+  return magic == other.magic && seed == other.seed && n_gen == other.n_gen &&
+         n_threads == other.n_threads && shard == other.shard &&
+         n_shards == other.n_shards && multiplicity == other.multiplicity &&
+         mixing_depth == other.mixing_depth &&
+         sampled_angles == other.sampled_angles &&
+         abundances_hash == other.abundances_hash;
+}
+
+// constructor
+
+CheckpointWriter::CheckpointWriter(std::string const& file_name,
+                                   CheckpointHeader const& header,
+                                   int queue_capacity)
+    : m_file_name{file_name},
+      m_header{header},
+      m_queue{queue_capacity},
+      m_thread{&CheckpointWriter::mWriteCheckpoints, this} {}
+
+CheckpointWriter::~CheckpointWriter() { close(); }
+
+// public methods
+
+void CheckpointWriter::save(int thread, int n_events_done, RandomEngine& rng,
+                            GenerationHistograms& histograms,
+                            EventMixer* mixer) {
+  CheckpointData checkpoint{thread, {}};
+  OutputArchive archive{checkpoint.data};
+  CheckpointHeader header{m_header};
+
+  header.serialize(archive);
+  serializeThread(archive, n_events_done, rng, histograms, mixer);
+
+  m_queue.push(std::move(checkpoint));
+}
+
+void CheckpointWriter::close() {
+  if (m_thread.joinable()) {
+    m_queue.close();
+    m_thread.join();
+  }
+}
+
+// private methods
+
+void CheckpointWriter::mWriteCheckpoints() {
+  while (auto checkpoint = m_queue.pop()) {
+    auto file_name = checkpointFileName(m_file_name, checkpoint->thread);
+    auto temporary_name = file_name + ".tmp";
+
+    std::ofstream file{temporary_name, std::ios::binary | std::ios::trunc};
+    file.write(checkpoint->data.data(), checkpoint->data.size());
+    file.close();
+
+    if (!file || std::rename(temporary_name.c_str(), file_name.c_str()) != 0) {
+      std::cout << "ERROR: Could not write the checkpoint " << file_name
+                << "!" << '\n';
+    }
+  }
+}
+
+std::string checkpointFileName(std::string const& file_name, int thread) {
+  return file_name + ".checkpoint." + std::to_string(thread);
+}
+
+int loadCheckpoint(std::string const& file_name,
+                   CheckpointHeader const& header, int thread,
+                   RandomEngine& rng, GenerationHistograms& histograms,
+                   EventMixer* mixer) {
+  std::ifstream file{checkpointFileName(file_name, thread), std::ios::binary};
+
+  if (!file) {
+    return 0;
+  }
+
+  std::string data{std::istreambuf_iterator<char>{file},
+                   std::istreambuf_iterator<char>{}};
+  InputArchive archive{data};
+  CheckpointHeader saved_header{};
+  int n_events_done{};
+
+  saved_header.serialize(archive);
+
+  if (!archive.ok() || !(saved_header == header)) {
+    return -1;
+  }
+
+  serializeThread(archive, n_events_done, rng, histograms, mixer);
+
+  return archive.ok() ? n_events_done : -1;
+}
+
+// FNV-1a over the bytes of the type ids and probabilities
+std::uint64_t hashAbundances(std::vector<SpeciesAbundance> const& abundances) {
+  std::uint64_t hash{0xcbf29ce484222325};
+
+  auto add = [&hash](void const* data, std::size_t size) {
+    for (std::size_t i{}; i < size; ++i) {
+      hash ^= static_cast<unsigned char const*>(data)[i];
+      hash *= 0x100000001b3;
+    }
+  };
+
+  for (auto const& abundance : abundances) {
+    add(&abundance.type_id, sizeof(abundance.type_id));
+    add(&abundance.probability, sizeof(abundance.probability));
+  }
+
+  return hash;
+}
+
+void removeCheckpoints(std::string const& file_name, int n_threads) {
+  for (int t{}; t < n_threads; ++t) {
+    std::remove(checkpointFileName(file_name, t).c_str());
+  }
+}
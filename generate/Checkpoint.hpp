@@ -0,0 +1,113 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BoundedQueue.hpp"
+
+class EventMixer;
+class RandomEngine;
+struct GenerationHistograms;
+struct SpeciesAbundance;
+
+// Arguments of the run stored at the start of every checkpoint. A run only
+// resumes from checkpoints written by a run with the same arguments
+struct CheckpointHeader {
+  static constexpr std::uint32_t MAGIC = 0x50434b33;
+
+  unsigned int seed;
+  int n_gen;
+  int n_threads;
+  int shard;
+  int n_shards;
+  int multiplicity;
+  int mixing_depth;
+  bool sampled_angles;
+  std::uint64_t abundances_hash;
+  std::uint32_t magic{MAGIC};
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(&magic, 1);
+    archive(&seed, 1);
+    archive(&n_gen, 1);
+    archive(&n_threads, 1);
+    archive(&shard, 1);
+    archive(&n_shards, 1);
+    archive(&multiplicity, 1);
+    archive(&mixing_depth, 1);
+    archive(&sampled_angles, 1);
+    archive(&abundances_hash, 1);
+  }
+
+  bool operator==(CheckpointHeader const&) const;
+};
+
+// State of a generation thread, serialized and waiting to be written
+struct CheckpointData {
+  int thread;
+  std::string data;
+};
+
+/**
+ * Writes the checkpoints of the generation threads, one file per thread next
+ * to the output file. A checkpoint holds the number of events the thread has
+ * generated, its random number engine, its histograms and accumulators and the
+ * events kept by its mixer, which is all a resumed run needs to produce the
+ * same output as an uninterrupted one. The Particle error counters are shared
+ * by all the threads and are not saved, so a resumed run only reports the
+ * errors of the events it generated.
+ *
+ * save() serializes the state in the calling thread, which is fast, and
+ * queues it. The files are written by a background thread, first to a
+ * temporary file that then replaces the previous checkpoint, so an interrupted
+ * write never leaves a broken checkpoint behind.
+ */
+class CheckpointWriter {
+ public:
+  CheckpointWriter(std::string const&, CheckpointHeader const&, int = 4);
+  ~CheckpointWriter();
+
+  void save(int, int, RandomEngine&, GenerationHistograms&, EventMixer*);
+  void close();
+
+ private:
+  std::string const m_file_name;
+  CheckpointHeader const m_header;
+  BoundedQueue<CheckpointData> m_queue;
+  std::thread m_thread;
+
+  void mWriteCheckpoints();
+};
+
+/**
+ * Name of the checkpoint file of a thread of the run writing to file_name.
+ */
+std::string checkpointFileName(std::string const& file_name, int thread);
+
+/**
+ * Restore the state of a generation thread from its checkpoint. Returns the
+ * number of events the thread had generated, 0 if there is no checkpoint and
+ * -1 if the checkpoint is broken or was written by a run with different
+ * arguments. The mixer must not have mixed any event yet.
+ */
+int loadCheckpoint(std::string const& file_name,
+                   CheckpointHeader const& header, int thread,
+                   RandomEngine& rng, GenerationHistograms& histograms,
+                   EventMixer* mixer);
+
+/**
+ * Hash of the abundances of the primary species, which identifies them in the
+ * checkpoint header.
+ */
+std::uint64_t hashAbundances(std::vector<SpeciesAbundance> const& abundances);
+
+/**
+ * Delete the checkpoint files of a run, once its output has been written.
+ */
+void removeCheckpoints(std::string const& file_name, int n_threads);
+
+#endif
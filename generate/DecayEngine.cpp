@@ -0,0 +1,217 @@
+#include "DecayEngine.hpp"
+
+#include <cmath>
+
+#include "EventBuffer.hpp"
+#include "Particle.hpp"
+#include "ParticleType.hpp"
+#include "RandomEngine.hpp"
+#include "ResonanceType.hpp"
+
+namespace {
+
+// momentum of the products of a two-body decay of a particle with mass m into
+// masses m1 and m2, in the rest frame of the decaying particle
+double twoBodyMomentum(double m, double m1, double m2) {
+  return std::sqrt((m * m - (m1 + m2) * (m1 + m2)) *
+                   (m * m - (m1 - m2) * (m1 - m2))) /
+         m * 0.5;
+}
+
+}  // namespace
+
+// constructor
+
+DecayEngine::DecayEngine() : m_first_channel{0}, m_first_daughter{0} {
+  int n_types = Particle::countParticleTypes();
+
+  for (int i{}; i < n_types; ++i) {
+    auto type = Particle::getParticleType(i);
+    auto resonance = dynamic_cast<ResonanceType const*>(type);
+
+    m_masses.push_back(type->getMass());
+    m_first_mass_point.push_back(m_mass_tables.size());
+
+    if (resonance != nullptr) {
+      auto const& mass_table = resonance->getMassTable();
+      m_mass_tables.insert(m_mass_tables.end(), mass_table.begin(),
+                           mass_table.end());
+
+      auto const& channels = resonance->getDecayChannels();
+      double total{};
+
+      for (auto const& channel : channels) {
+        total += channel.branching_ratio;
+      }
+
+      // the ratios are normalized, so they do not have to add up to one
+      double cumulative{};
+
+      for (auto const& channel : channels) {
+        cumulative += channel.branching_ratio;
+        m_cumulative_ratios.push_back(cumulative / total);
+
+        m_daughters.insert(m_daughters.end(), channel.daughters.begin(),
+                           channel.daughters.end());
+        m_first_daughter.push_back(m_daughters.size());
+      }
+    }
+
+    m_first_channel.push_back(m_cumulative_ratios.size());
+  }
+}
+
+// public methods
+
+// decays every unstable particle of the event, including the products of
+// previous decays, and appends the products after the particles already in the
+// event. The products of each decay are stored next to each other, with the
+// index of the decayed particle as parent. Returns the number of decays that
+// could not be performed
+int DecayEngine::decay(EventBuffer& event, RandomEngine& engine) const {
+  int n_failed{};
+
+  for (int i{}; i < event.size(); ++i) {
+    if (isUnstable(event.getTypeId()[i]) && mDecay(event, i, engine) != 0) {
+      ++n_failed;
+    }
+  }
+
+  return n_failed;
+}
+
+bool DecayEngine::isUnstable(int type_id) const {
+  int n_types = m_masses.size();
+
+  return type_id >= 0 && type_id < n_types &&
+         m_first_channel[type_id] != m_first_channel[type_id + 1];
+}
+
+// private methods
+
+int DecayEngine::mDecay(EventBuffer& event, int i, RandomEngine& engine) const {
+  int type_id = event.getTypeId()[i];
+
+  // the channel is picked first, then the mass is drawn from the line shape.
+  // The line shape is truncated at the threshold of the heaviest channel, so
+  // the decay is always allowed
+  double x = engine.uniform();
+  int channel = m_first_channel[type_id];
+  int last_channel = m_first_channel[type_id + 1] - 1;
+
+  while (channel < last_channel && x > m_cumulative_ratios[channel]) {
+    ++channel;
+  }
+
+  if (m_masses[type_id] == 0.0) {
+    Particle::mAddError(Particle::ZERO_MASS_DECAY);
+    return 1;
+  }
+
+  double mass = interpolateMassTable(
+      m_mass_tables.data() + m_first_mass_point[type_id], engine.uniform());
+
+  int const* daughters = m_daughters.data() + m_first_daughter[channel];
+  int n_daughters = m_first_daughter[channel + 1] - m_first_daughter[channel];
+  double daughter_masses[MAX_DAUGHTERS]{};
+
+  for (int d{}; d < n_daughters; ++d) {
+    daughter_masses[d] = m_masses[daughters[d]];
+  }
+
+  LorentzVector products[MAX_DAUGHTERS]{};
+
+  if (n_daughters == 2) {
+    mDecayTwoBody(mass, daughter_masses, engine, products);
+  } else {
+    mDecayThreeBody(mass, daughter_masses, engine, products);
+  }
+
+  // all the products share the velocity of the decayed particle
+  double px = event.getPx()[i];
+  double py = event.getPy()[i];
+  double pz = event.getPz()[i];
+  double energy = std::sqrt(px * px + py * py + pz * pz + mass * mass);
+
+  boostVectors(products, n_daughters, px / energy, py / energy, pz / energy);
+
+  Particle product{};
+
+  for (int d{}; d < n_daughters; ++d) {
+    product.setIndex(daughters[d]);
+    product.setMomentum(products[d].px, products[d].py, products[d].pz);
+    event.push(product, i);
+  }
+
+  return 0;
+}
+
+// products of a two-body decay in the rest frame of the decaying particle,
+// with the same angles as Particle::decayToBody
+void DecayEngine::mDecayTwoBody(double mass, double const* masses,
+                                RandomEngine& engine,
+                                LorentzVector* products) const {
+  double p = twoBodyMomentum(mass, masses[0], masses[1]);
+
+  double phi = engine.uniform(0., 2. * M_PI);
+  double theta = engine.uniform(-M_PI / 2., M_PI / 2.);
+
+  products[0] = LorentzVector::fromMass(p * std::sin(theta) * std::cos(phi),
+                                        p * std::sin(theta) * std::sin(phi),
+                                        p * std::cos(theta), masses[0]);
+  products[1] = LorentzVector::fromMass(-p * std::sin(theta) * std::cos(phi),
+                                        -p * std::sin(theta) * std::sin(phi),
+                                        -p * std::cos(theta), masses[1]);
+}
+
+// products of a three-body decay distributed uniformly in phase space, in the
+// rest frame of the decaying particle. The mass of the (1, 2) pair is drawn
+// with the accept-reject method of the GENBOD algorithm, then the pair decays
+// isotropically in its own frame, which recoils against the third product
+void DecayEngine::mDecayThreeBody(double mass, double const* masses,
+                                  RandomEngine& engine,
+                                  LorentzVector* products) const {
+  double kinetic = mass - masses[0] - masses[1] - masses[2];
+  double max_weight =
+      twoBodyMomentum(kinetic + masses[0] + masses[1], masses[0], masses[1]) *
+      twoBodyMomentum(mass, masses[0] + masses[1], masses[2]);
+
+  double pair_mass{};
+  double pair_p{};
+  double recoil_p{};
+
+  do {
+    pair_mass = masses[0] + masses[1] + kinetic * engine.uniform();
+    pair_p = twoBodyMomentum(pair_mass, masses[0], masses[1]);
+    recoil_p = twoBodyMomentum(mass, pair_mass, masses[2]);
+  } while (engine.uniform() * max_weight > pair_p * recoil_p);
+
+  // isotropic directions, from a uniform cos(theta)
+  double cos_theta = engine.uniform(-1., 1.);
+  double sin_theta = std::sqrt(1. - cos_theta * cos_theta);
+  double phi = engine.uniform(0., 2. * M_PI);
+  double x = sin_theta * std::cos(phi);
+  double y = sin_theta * std::sin(phi);
+  double z = cos_theta;
+
+  products[0] = LorentzVector::fromMass(pair_p * x, pair_p * y, pair_p * z,
+                                        masses[0]);
+  products[1] = LorentzVector::fromMass(-pair_p * x, -pair_p * y,
+                                        -pair_p * z, masses[1]);
+
+  cos_theta = engine.uniform(-1., 1.);
+  sin_theta = std::sqrt(1. - cos_theta * cos_theta);
+  phi = engine.uniform(0., 2. * M_PI);
+  x = sin_theta * std::cos(phi);
+  y = sin_theta * std::sin(phi);
+  z = cos_theta;
+
+  products[2] = LorentzVector::fromMass(recoil_p * x, recoil_p * y,
+                                        recoil_p * z, masses[2]);
+
+  // the pair moves opposite to the third product
+  double pair_energy = std::sqrt(pair_mass * pair_mass + recoil_p * recoil_p);
+  double pair_beta = recoil_p / pair_energy;
+
+  boostVectors(products, 2, -pair_beta * x, -pair_beta * y, -pair_beta * z);
+}
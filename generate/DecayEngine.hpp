@@ -0,0 +1,45 @@
+#ifndef DECAY_ENGINE_HPP
+#define DECAY_ENGINE_HPP
+
+#include <vector>
+
+#include "LorentzVector.hpp"
+
+class EventBuffer;
+class RandomEngine;
+
+// Decays the resonances of whole events following the channels registered on
+// each ResonanceType. The masses, line shape tables and channels of all the
+// particle types are copied into flat arrays when the engine is built, so it
+// has to be created after the types and channels have been added. Two- and
+// three-body channels are supported.
+class DecayEngine {
+ public:
+  DecayEngine();
+
+  int decay(EventBuffer&, RandomEngine&) const;
+  bool isUnstable(int) const;
+
+ private:
+  std::vector<double> m_masses;
+
+  // inverse cumulative distributions of the line shapes, MASS_TABLE_POINTS
+  // values for each resonance starting at m_first_mass_point
+  std::vector<int> m_first_mass_point;
+  std::vector<double> m_mass_tables;
+
+  // channels of the i-th type are in [m_first_channel[i],
+  // m_first_channel[i + 1]), their daughters in the same way
+  std::vector<int> m_first_channel;
+  std::vector<double> m_cumulative_ratios;
+  std::vector<int> m_first_daughter;
+  std::vector<int> m_daughters;
+
+  int mDecay(EventBuffer&, int, RandomEngine&) const;
+  void mDecayTwoBody(double, double const*, RandomEngine&,
+                     LorentzVector*) const;
+  void mDecayThreeBody(double, double const*, RandomEngine&,
+                       LorentzVector*) const;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef EVENT_ARENA_HPP
+#define EVENT_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for the scratch arrays of one event, owned by a generation
+// thread. Arrays are carved out of a single block and are all released at
+// once by reset(), which only moves the offset back to the start.
+//
+// An event that needs more than the block holds gets the rest from separate
+// blocks. The next reset() frees them and replaces the block with one that
+// fits the whole event, so after the first few events the arena does not
+// touch the heap any more. The arrays are aligned to cache lines and are not
+// initialized.
+class EventArena {
+ public:
+  EventArena(std::size_t capacity = 1 << 16) { mAllocateBlock(capacity); }
+
+  template <class T>
+  T* allocate(int n) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "the arena never runs destructors");
+
+    std::size_t bytes = mRoundUp(n * sizeof(T));
+
+    if (m_used + bytes > m_capacity) {
+      m_overflow.emplace_back(bytes + ALIGNMENT);
+      m_overflow_bytes += bytes;
+      return reinterpret_cast<T*>(mAlign(m_overflow.back().data()));
+    }
+
+    T* data = reinterpret_cast<T*>(m_data + m_used);
+    m_used += bytes;
+    return data;
+  }
+
+  void reset() {
+    if (!m_overflow.empty()) {
+      mAllocateBlock(m_used + m_overflow_bytes);
+      m_overflow.clear();
+      m_overflow_bytes = 0;
+    }
+
+    m_used = 0;
+  }
+
+  // getters
+
+  std::size_t capacity() const { return m_capacity; }
+  std::size_t used() const { return m_used + m_overflow_bytes; }
+
+ private:
+  static constexpr std::size_t ALIGNMENT = 64;
+
+  std::vector<std::byte> m_block;
+  std::byte* m_data;
+  std::size_t m_capacity;
+  std::size_t m_used{};
+
+  // blocks of the arrays that did not fit since the last reset
+  std::vector<std::vector<std::byte>> m_overflow;
+  std::size_t m_overflow_bytes{};
+
+  static std::size_t mRoundUp(std::size_t bytes) {
+    return (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  }
+
+  static std::byte* mAlign(std::byte* data) {
+    auto address = reinterpret_cast<std::uintptr_t>(data);
+    return data + (mRoundUp(address) - address);
+  }
+
+  void mAllocateBlock(std::size_t capacity) {
+    m_capacity = mRoundUp(capacity);
+    m_block = std::vector<std::byte>(m_capacity + ALIGNMENT);
+    m_data = mAlign(m_block.data());
+  }
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include "EventBuffer.hpp"
+
+#include <algorithm>
+
+#include "Kinematics.hpp"
+
+// constructor
+
+EventBuffer::EventBuffer(int capacity) : m_size{0} { mReserve(capacity); }
+
+// public methods
+
+void EventBuffer::clear() { m_size = 0; }
+
+void EventBuffer::resize(int size) {
+  if (size > capacity()) {
+    mReserve(size);
+  }
+
+  for (int i{m_size}; i < size; ++i) {
+    m_px[i] = m_py[i] = m_pz[i] = 0.;
+    m_energy[i] = m_mass[i] = 0.;
+    m_charge[i] = 0;
+    m_type_id[i] = -1;
+    m_parent[i] = -1;
+  }
+
+  m_size = size;
+}
+
+int EventBuffer::push(Particle const& particle, int parent) {
+  if (m_size == capacity()) {
+    mReserve(std::max(1, capacity() * 2));
+  }
+
+  set(m_size, particle, parent);
+
+  return m_size++;
+}
+
+void EventBuffer::set(int i, Particle const& particle, int parent) {
+  auto momentum = particle.getMomentum();
+  auto index = particle.getIndex();
+
+  m_parent[i] = parent;
+
+  m_px[i] = momentum.x;
+  m_py[i] = momentum.y;
+  m_pz[i] = momentum.z;
+
+  if (index != std::nullopt) {
+    m_energy[i] = particle.getEnergyUnchecked();
+    m_mass[i] = particle.getMassUnchecked();
+    m_charge[i] = particle.getChargeUnchecked();
+    m_type_id[i] = index.value();
+  } else {
+    m_energy[i] = m_mass[i] = 0.;
+    m_charge[i] = 0;
+    m_type_id[i] = -1;
+  }
+}
+
+// replaces the content of the buffer with n primaries of the given types,
+// converting their spherical momenta directly into the momentum arrays
+void EventBuffer::setPrimaries(int n, int const* type_ids, double const* p,
+                               double const* theta, double const* phi) {
+  if (n > capacity()) {
+    mReserve(n);
+  }
+
+  m_size = n;
+
+  sphericalToCartesian(p, theta, phi, n, m_px.data(), m_py.data(),
+                       m_pz.data());
+
+  int n_types = Particle::countParticleTypes();
+  Particle particle{};
+
+  for (int i{}; i < n; ++i) {
+    m_parent[i] = -1;
+
+    if (type_ids[i] >= 0 && type_ids[i] < n_types) {
+      particle.setIndex(type_ids[i]);
+      particle.setMomentum(m_px[i], m_py[i], m_pz[i]);
+
+      m_energy[i] = particle.getEnergyUnchecked();
+      m_mass[i] = particle.getMassUnchecked();
+      m_charge[i] = particle.getChargeUnchecked();
+      m_type_id[i] = type_ids[i];
+    } else {
+      m_energy[i] = m_mass[i] = 0.;
+      m_charge[i] = 0;
+      m_type_id[i] = -1;
+    }
+  }
+}
+
+// getters
+
+int EventBuffer::size() const { return m_size; }
+
+int EventBuffer::capacity() const { return m_px.size(); }
+
+Particle EventBuffer::getParticle(int i) const {
+  Particle particle{"", {m_px[i], m_py[i], m_pz[i]}};
+
+  if (m_type_id[i] >= 0) {
+    particle.setIndex(m_type_id[i]);
+  }
+
+  return particle;
+}
+
+double const* EventBuffer::getPx() const { return m_px.data(); }
+
+double const* EventBuffer::getPy() const { return m_py.data(); }
+
+double const* EventBuffer::getPz() const { return m_pz.data(); }
+
+double const* EventBuffer::getEnergy() const { return m_energy.data(); }
+
+double const* EventBuffer::getMass() const { return m_mass.data(); }
+
+int const* EventBuffer::getCharge() const { return m_charge.data(); }
+
+int const* EventBuffer::getTypeId() const { return m_type_id.data(); }
+
+int const* EventBuffer::getParent() const { return m_parent.data(); }
+
+// private methods
+
+void EventBuffer::mReserve(int capacity) {
+  m_px.resize(capacity);
+  m_py.resize(capacity);
+  m_pz.resize(capacity);
+  m_energy.resize(capacity);
+  m_mass.resize(capacity);
+  m_charge.resize(capacity);
+  m_type_id.resize(capacity);
+  m_parent.resize(capacity);
+}
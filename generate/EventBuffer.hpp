@@ -0,0 +1,55 @@
+#ifndef EVENT_BUFFER_HPP
+#define EVENT_BUFFER_HPP
+
+#include <vector>
+
+#include "Particle.hpp"
+
+// Structure-of-arrays storage for the particles of a single event. Every
+// particle property lives in its own contiguous array, so loops over the event
+// only touch the data they need. The buffer is meant to be reused across
+// events: clear() keeps the allocated capacity.
+class EventBuffer {
+ public:
+  EventBuffer(int = 300);
+
+  void clear();
+  void resize(int);
+  int push(Particle const&, int = -1);
+  void set(int, Particle const&, int = -1);
+  void setPrimaries(int, int const*, double const*, double const*,
+                    double const*);
+
+  // getters
+
+  int size() const;
+  int capacity() const;
+  Particle getParticle(int) const;
+
+  double const* getPx() const;
+  double const* getPy() const;
+  double const* getPz() const;
+  double const* getEnergy() const;
+  double const* getMass() const;
+  int const* getCharge() const;
+  int const* getTypeId() const;
+  int const* getParent() const;
+
+ private:
+  int m_size;
+
+  std::vector<double> m_px;
+  std::vector<double> m_py;
+  std::vector<double> m_pz;
+  std::vector<double> m_energy;
+  std::vector<double> m_mass;
+  std::vector<int> m_charge;
+  std::vector<int> m_type_id;
+
+  // index of the particle this one was produced by, -1 for primaries
+  std::vector<int> m_parent;
+
+  void mReserve(int);
+};
+
+#endif
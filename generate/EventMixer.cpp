@@ -0,0 +1,98 @@
+#include "EventMixer.hpp"
+
+#include <utility>
+
+#include "InvariantMass.hpp"
+#include "ParticleTypeTable.hpp"
+#include "generate.hpp"
+
+// constructor
+
+EventMixer::EventMixer(GenerationHistograms& histograms, int depth,
+                       int queue_capacity)
+    : m_histograms{histograms},
+      m_depth{depth},
+      m_queue{queue_capacity},
+      m_free_events{queue_capacity},
+      m_thread{&EventMixer::mMixEvents, this} {}
+
+EventMixer::~EventMixer() { close(); }
+
+// public methods
+
+void EventMixer::mix(PairArrays const& particles, unsigned const* class_masks) {
+  auto n = particles.size;
+  MixedEvent event = m_free_events.tryPop().value_or(MixedEvent{});
+
+  event.px.assign(particles.px, particles.px + n);
+  event.py.assign(particles.py, particles.py + n);
+  event.pz.assign(particles.pz, particles.pz + n);
+  event.energy.assign(particles.energy, particles.energy + n);
+  event.class_masks.assign(class_masks, class_masks + n);
+
+  ++m_n_handed;
+  m_queue.push(std::move(event));
+}
+
+void EventMixer::drain() {
+  std::unique_lock<std::mutex> lock{m_mutex};
+  m_mixed.wait(lock, [this] { return m_n_mixed == m_n_handed; });
+}
+
+void EventMixer::close() {
+  if (m_thread.joinable()) {
+    m_queue.close();
+    m_thread.join();
+  }
+}
+
+// private methods
+
+void EventMixer::mMixEvents() {
+  std::vector<double> masses{};
+
+  while (auto event = m_queue.pop()) {
+    for (auto const& previous : m_previous_events) {
+      int n_previous = previous.px.size();
+
+      if (static_cast<int>(masses.size()) < n_previous) {
+        masses.resize(n_previous);
+      }
+
+      for (int i{}; i < static_cast<int>(event->px.size()); ++i) {
+        computeInvariantMasses(event->px[i], event->py[i], event->pz[i],
+                               event->energy[i], previous.px.data(),
+                               previous.py.data(), previous.pz.data(),
+                               previous.energy.data(), n_previous,
+                               masses.data());
+
+        for (int j{}; j < n_previous; ++j) {
+          auto pair_class =
+              getPairClass(event->class_masks[i], previous.class_masks[j]);
+
+          if (pair_class & OPPOSITE_CHARGE) {
+            m_histograms.invm_mixed_opposite_charge.fill(masses[j]);
+          }
+
+          if (pair_class & PION_KAON_OPPOSITE) {
+            m_histograms.invm_mixed_pion_kaon_opposite.fill(masses[j]);
+          }
+        }
+      }
+    }
+
+    if (static_cast<int>(m_previous_events.size()) < m_depth) {
+      m_previous_events.push_back(std::move(*event));
+    } else {
+      std::swap(m_previous_events[m_next], *event);
+      m_next = (m_next + 1) % m_depth;
+
+      // the oldest event goes back to be refilled
+      m_free_events.tryPush(std::move(*event));
+    }
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    ++m_n_mixed;
+    m_mixed.notify_all();
+  }
+}
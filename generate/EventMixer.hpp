@@ -0,0 +1,90 @@
+#ifndef EVENT_MIXER_HPP
+#define EVENT_MIXER_HPP
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BoundedQueue.hpp"
+#include "PairEngine.hpp"
+
+struct GenerationHistograms;
+
+// Final-state particles of an event handed to the mixer, with their
+// ParticleClass flags
+struct MixedEvent {
+  std::vector<double> px;
+  std::vector<double> py;
+  std::vector<double> pz;
+  std::vector<double> energy;
+  std::vector<unsigned> class_masks;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(px);
+    archive(py);
+    archive(pz);
+    archive(energy);
+    archive(class_masks);
+  }
+};
+
+// Builds the mixed-event background: every event is paired with the depth
+// events that came before it, and the pairs fill the mixed invariant mass
+// accumulators of the given histograms. The pairing runs on a background
+// thread, fed through a bounded queue, so it overlaps with the generation of
+// the next events. The histograms are only complete once close() returns.
+// mix copies the particles to a MixedEvent taken back from the mixing thread
+// when one is free, so the events are not allocated after the first ones.
+//
+// drain() waits until every event handed to the mixer has been mixed. The
+// events kept for mixing can then be saved with serialize, which restores
+// them as well on a mixer that has not mixed any event yet.
+class EventMixer {
+ public:
+  EventMixer(GenerationHistograms&, int, int = 64);
+  ~EventMixer();
+
+  void mix(PairArrays const&, unsigned const*);
+  void drain();
+  void close();
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    int n_events = m_previous_events.size();
+
+    archive(&m_next, 1);
+    archive(&n_events, 1);
+    m_previous_events.resize(n_events);
+
+    for (auto& event : m_previous_events) {
+      event.serialize(archive);
+    }
+  }
+
+ private:
+  GenerationHistograms& m_histograms;
+  int const m_depth;
+  BoundedQueue<MixedEvent> m_queue;
+
+  // events dropped from the mixing ring, waiting to be refilled
+  BoundedQueue<MixedEvent> m_free_events;
+
+  // ring of the last m_depth events, m_next is the slot of the oldest one once
+  // the ring is full. Only used by the mixing thread, or after drain()
+  std::vector<MixedEvent> m_previous_events;
+  int m_next{};
+
+  // number of events handed to the mixer and mixed so far
+  long long m_n_handed{};
+  long long m_n_mixed{};
+  std::mutex m_mutex;
+  std::condition_variable m_mixed;
+
+  std::thread m_thread;
+
+  void mMixEvents();
+};
+
+#endif
@@ -0,0 +1,122 @@
+#include "EventWriter.hpp"
+
+#include <iostream>
+
+#include "EventBuffer.hpp"
+#include "TDirectory.h"
+#include "TFile.h"
+#include "TTree.h"
+
+// constructor
+
+EventWriter::EventWriter(std::string const& file_name, int queue_capacity)
+    : m_file_name{file_name},
+      m_queue{queue_capacity},
+      m_file{nullptr},
+      m_ok{false},
+      m_free_records{queue_capacity} {
+  {
+    // the file must not become the current directory of the calling thread
+    TDirectory::TContext context{};
+    m_file = new TFile(m_file_name.c_str(), "RECREATE");
+  }
+
+  if (m_file->IsZombie()) {
+    std::cout << "ERROR: Could not write the events file " << m_file_name
+              << "!" << '\n';
+
+    delete m_file;
+    m_file = nullptr;
+  }
+
+  m_ok = m_file != nullptr;
+  m_thread = std::thread{&EventWriter::mWriteEvents, this};
+}
+
+EventWriter::~EventWriter() { close(); }
+
+// public methods
+
+void EventWriter::write(int thread, int event, EventBuffer const& buffer) {
+  auto n = buffer.size();
+
+  // a new record is only built while the writer has not returned any yet
+  EventRecord record = m_free_records.tryPop().value_or(EventRecord{});
+
+  record.thread = thread;
+  record.event = event;
+  record.px.assign(buffer.getPx(), buffer.getPx() + n);
+  record.py.assign(buffer.getPy(), buffer.getPy() + n);
+  record.pz.assign(buffer.getPz(), buffer.getPz() + n);
+  record.type_id.assign(buffer.getTypeId(), buffer.getTypeId() + n);
+  record.parent.assign(buffer.getParent(), buffer.getParent() + n);
+
+  m_queue.push(std::move(record));
+}
+
+bool EventWriter::close() {
+  if (m_thread.joinable()) {
+    m_queue.close();
+    m_thread.join();
+  }
+
+  return m_ok;
+}
+
+bool EventWriter::isOpen() const { return m_file != nullptr; }
+
+// private methods
+
+void EventWriter::mWriteEvents() {
+  if (m_file == nullptr) {
+    // nothing can be written, the events are dropped
+    while (m_queue.pop()) {
+    }
+
+    return;
+  }
+
+  // from here on the file and the tree are only touched by this thread. The
+  // tree is owned by the file, which deletes it when closed
+  m_file->cd();
+  TTree* tree = new TTree("events", "Generated events");
+
+  int thread{};
+  int event{};
+  int n{};
+  double dummy_d[1]{};
+  int dummy_i[1]{};
+
+  tree->Branch("thread", &thread, "thread/I");
+  tree->Branch("event", &event, "event/I");
+  tree->Branch("n", &n, "n/I");
+  auto px_branch = tree->Branch("px", dummy_d, "px[n]/D");
+  auto py_branch = tree->Branch("py", dummy_d, "py[n]/D");
+  auto pz_branch = tree->Branch("pz", dummy_d, "pz[n]/D");
+  auto type_branch = tree->Branch("type", dummy_i, "type[n]/I");
+  auto parent_branch = tree->Branch("parent", dummy_i, "parent[n]/I");
+
+  while (auto record = m_queue.pop()) {
+    thread = record->thread;
+    event = record->event;
+    n = record->px.size();
+
+    // the arrays are read straight from the record
+    px_branch->SetAddress(record->px.data());
+    py_branch->SetAddress(record->py.data());
+    pz_branch->SetAddress(record->pz.data());
+    type_branch->SetAddress(record->type_id.data());
+    parent_branch->SetAddress(record->parent.data());
+
+    if (tree->Fill() < 0) {
+      m_ok = false;
+    }
+
+    m_free_records.tryPush(std::move(*record));
+  }
+
+  m_file->Write();
+  m_file->Close();
+
+  delete m_file;
+}
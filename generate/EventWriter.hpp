@@ -0,0 +1,67 @@
+#ifndef EVENT_WRITER_HPP
+#define EVENT_WRITER_HPP
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BoundedQueue.hpp"
+
+class EventBuffer;
+class TFile;
+
+// Particles of one generated event, laid out like the entries of the tree
+struct EventRecord {
+  int thread;
+  int event;
+
+  std::vector<double> px;
+  std::vector<double> py;
+  std::vector<double> pz;
+  std::vector<int> type_id;
+  std::vector<int> parent;
+};
+
+/**
+ * Streams generated events to the "events" TTree of a ROOT file, one entry per
+ * event with the kinematics, type ids and parent indices of its particles. The
+ * events are copied to a bounded queue and written by a background thread, so
+ * the generation threads only wait when the writer falls behind by more than
+ * the queue capacity. Written records are handed back to the generation threads
+ * through a second queue and refilled, so once the queue has filled up the
+ * records are not allocated any more.
+ *
+ * The file is opened by the constructor, so that a file that cannot be written
+ * is reported before the generation starts. The events sent to a writer that is
+ * not open are dropped. close() returns false if the file could not be opened
+ * or an event could not be written.
+ */
+class EventWriter {
+ public:
+  EventWriter(std::string const&, int = 256);
+  ~EventWriter();
+
+  void write(int, int, EventBuffer const&);
+  bool close();
+
+  bool isOpen() const;
+
+ private:
+  std::string const m_file_name;
+  BoundedQueue<EventRecord> m_queue;
+
+  // owned by the writing thread once it has started, null if the file could
+  // not be opened
+  TFile* m_file;
+  std::atomic<bool> m_ok;
+
+  // written records waiting to be refilled. When it is full, a written record
+  // is dropped so that the writer never waits on the generation threads
+  BoundedQueue<EventRecord> m_free_records;
+  std::thread m_thread;
+
+  void mWriteEvents();
+};
+
+#endif
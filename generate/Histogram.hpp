@@ -0,0 +1,133 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <vector>
+
+#include "TH1.h"
+
+/**
+ * Fixed binning histogram accumulating counts, sums of squared weights and the
+ * statistics kept by TH1. The axis is a type with static constexpr n_bins, low
+ * and high members, so the bin edges are known at compile time. Filling does
+ * not go through the ROOT machinery: the content is copied to a TH1 with the
+ * same binning only when it has to be written.
+ */
+template <class Axis>
+class Histogram {
+ public:
+  static constexpr int n_bins = Axis::n_bins;
+  static constexpr double low = Axis::low;
+  static constexpr double high = Axis::high;
+
+  Histogram() : m_counts(n_bins + 2), m_sumw2(n_bins + 2) {}
+
+  // same bin lookup as TAxis::FindFixBin, 0 is the underflow and n_bins + 1
+  // the overflow bin
+  static int findBin(double x) {
+    if (x < low) {
+      return 0;
+    }
+
+    if (!(x < high)) {
+      return n_bins + 1;
+    }
+
+    return 1 + static_cast<int>(n_bins * (x - low) / (high - low));
+  }
+
+  void fill(double x) {
+    int bin = findBin(x);
+
+    m_counts[bin] += 1.;
+    m_sumw2[bin] += 1.;
+    m_entries += 1.;
+
+    // like TH1, the statistics only include values inside the axis range
+    if (bin != 0 && bin != n_bins + 1) {
+      m_tsumw += 1.;
+      m_tsumw2 += 1.;
+      m_tsumwx += x;
+      m_tsumwx2 += x * x;
+    }
+  }
+
+  void fillN(double const* values, int n) {
+    for (int i{}; i < n; ++i) {
+      fill(values[i]);
+    }
+  }
+
+  void add(Histogram const& histogram) {
+    for (int bin{}; bin < n_bins + 2; ++bin) {
+      m_counts[bin] += histogram.m_counts[bin];
+      m_sumw2[bin] += histogram.m_sumw2[bin];
+    }
+
+    m_entries += histogram.m_entries;
+    m_tsumw += histogram.m_tsumw;
+    m_tsumw2 += histogram.m_tsumw2;
+    m_tsumwx += histogram.m_tsumwx;
+    m_tsumwx2 += histogram.m_tsumwx2;
+  }
+
+  void reset() {
+    for (int bin{}; bin < n_bins + 2; ++bin) {
+      m_counts[bin] = m_sumw2[bin] = 0.;
+    }
+
+    m_entries = m_tsumw = m_tsumw2 = m_tsumwx = m_tsumwx2 = 0.;
+  }
+
+  // passes the content and the statistics to archive, which saves or restores
+  // them
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(m_counts.data(), n_bins + 2);
+    archive(m_sumw2.data(), n_bins + 2);
+    archive(&m_entries, 1);
+    archive(&m_tsumw, 1);
+    archive(&m_tsumw2, 1);
+    archive(&m_tsumwx, 1);
+    archive(&m_tsumwx2, 1);
+  }
+
+  // getters
+
+  double getBinContent(int bin) const { return m_counts[bin]; }
+  double getEntries() const { return m_entries; }
+
+  /**
+   * Overwrite the content of a TH1 with the same binning, leaving it as if
+   * every value had been passed to TH1::Fill.
+   */
+  void copyTo(TH1* histogram) const {
+    auto sumw2 = histogram->GetSumw2();
+    bool has_sumw2 = histogram->GetSumw2N() > 0;
+
+    for (int bin{}; bin < n_bins + 2; ++bin) {
+      histogram->SetBinContent(bin, m_counts[bin]);
+
+      if (has_sumw2) {
+        (*sumw2)[bin] = m_sumw2[bin];
+      }
+    }
+
+    // SetBinContent changes the entries and statistics, so they are restored
+    // once all the bins are set
+    double stats[4]{m_tsumw, m_tsumw2, m_tsumwx, m_tsumwx2};
+    histogram->PutStats(stats);
+    histogram->SetEntries(m_entries);
+  }
+
+ private:
+  std::vector<double> m_counts;
+  std::vector<double> m_sumw2;
+
+  double m_entries{};
+  double m_tsumw{};
+  double m_tsumw2{};
+  double m_tsumwx{};
+  double m_tsumwx2{};
+};
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef INSTRUMENTATION_HPP
+#define INSTRUMENTATION_HPP
+
+// Opt-in counters of the time spent in each stage of the generation. Define
+// PARTICLES_INSTRUMENT when compiling to enable them, otherwise every
+// INSTRUMENT_* macro expands to nothing and the generator is unchanged.
+
+#ifdef PARTICLES_INSTRUMENT
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+enum InstrumentedStage : int {
+  STAGE_KINEMATICS,
+  STAGE_TYPE,
+  STAGE_DECAY,
+  STAGE_PARTICLE_HISTOGRAMS,
+  STAGE_PAIR_LOOP,
+  N_INSTRUMENTED_STAGES
+};
+
+constexpr char const* INSTRUMENTED_STAGE_NAMES[N_INSTRUMENTED_STAGES]{
+    "kinematics sampling",        "type assignment",
+    "resonance decays",           "single particle histograms",
+    "pair loop"};
+
+// time stamp counter cycles, or nanoseconds where it is not available
+inline std::uint64_t instrumentationNow() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+struct StageCounters {
+  std::uint64_t cycles[N_INSTRUMENTED_STAGES]{};
+  std::uint64_t calls[N_INSTRUMENTED_STAGES]{};
+  std::uint64_t failed_decays{};
+
+  void record(int stage, std::uint64_t stage_cycles) {
+    cycles[stage] += stage_cycles;
+    ++calls[stage];
+  }
+
+  void add(StageCounters const& counters) {
+    for (int stage{}; stage < N_INSTRUMENTED_STAGES; ++stage) {
+      cycles[stage] += counters.cycles[stage];
+      calls[stage] += counters.calls[stage];
+    }
+
+    failed_decays += counters.failed_decays;
+  }
+
+  void print(std::ostream& os) const {
+    std::uint64_t total_cycles{};
+
+    for (auto stage_cycles : cycles) {
+      total_cycles += stage_cycles;
+    }
+
+    os << "STAGE COUNTERS" << '\n';
+
+    for (int stage{}; stage < N_INSTRUMENTED_STAGES; ++stage) {
+      os << INSTRUMENTED_STAGE_NAMES[stage] << ": " << calls[stage]
+         << " calls, " << cycles[stage] << " cycles";
+
+      if (calls[stage] > 0) {
+        os << ", " << cycles[stage] / calls[stage] << " cycles/call";
+      }
+
+      if (total_cycles > 0) {
+        os << ", " << 100. * cycles[stage] / total_cycles << '%';
+      }
+
+      os << '\n';
+    }
+
+    os << "Failed decays: " << failed_decays << '\n';
+  }
+};
+
+// every thread counts in its own copy, which is added to the total when the
+// thread is done
+inline thread_local StageCounters g_thread_stage_counters{};
+inline StageCounters g_stage_counters{};
+inline std::mutex g_stage_counters_mutex{};
+
+#define INSTRUMENT_BEGIN(stage) \
+  auto const instrument_begin_##stage = instrumentationNow()
+
+#define INSTRUMENT_END(stage)     \
+  g_thread_stage_counters.record( \
+      stage, instrumentationNow() - instrument_begin_##stage)
+
+#define INSTRUMENT_FAILED_DECAYS(n) g_thread_stage_counters.failed_decays += (n)
+
+#define INSTRUMENT_MERGE_THREAD()                             \
+  do {                                                        \
+    std::lock_guard<std::mutex> lock{g_stage_counters_mutex}; \
+    g_stage_counters.add(g_thread_stage_counters);            \
+    g_thread_stage_counters = StageCounters{};                \
+  } while (false)
+
+#define INSTRUMENT_REPORT(os)           \
+  do {                                  \
+    g_stage_counters.print(os);         \
+    g_stage_counters = StageCounters{}; \
+  } while (false)
+
+#else
+
+#define INSTRUMENT_BEGIN(stage)
+#define INSTRUMENT_END(stage)
+#define INSTRUMENT_FAILED_DECAYS(n) static_cast<void>(n)
+#define INSTRUMENT_MERGE_THREAD()
+#define INSTRUMENT_REPORT(os)
+
+#endif
+
+#endif
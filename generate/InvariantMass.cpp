@@ -0,0 +1,78 @@
+#include "InvariantMass.hpp"
+
+#include <cmath>
+
+#include "EventBuffer.hpp"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// The vector paths use separate multiplications and additions in the same
+// order as the scalar loop instead of fused multiply-adds, so that every path
+// rounds exactly like Particle::getInvariantMass.
+
+void computeInvariantMasses(double px, double py, double pz, double energy,
+                            double const* px_j, double const* py_j,
+                            double const* pz_j, double const* energy_j, int n,
+                            double* masses) {
+  int j{};
+
+#if defined(__AVX512F__)
+  auto const px_v = _mm512_set1_pd(px);
+  auto const py_v = _mm512_set1_pd(py);
+  auto const pz_v = _mm512_set1_pd(pz);
+  auto const energy_v = _mm512_set1_pd(energy);
+
+  for (; j + 8 <= n; j += 8) {
+    auto x = _mm512_add_pd(px_v, _mm512_loadu_pd(px_j + j));
+    auto y = _mm512_add_pd(py_v, _mm512_loadu_pd(py_j + j));
+    auto z = _mm512_add_pd(pz_v, _mm512_loadu_pd(pz_j + j));
+    auto e = _mm512_add_pd(energy_v, _mm512_loadu_pd(energy_j + j));
+
+    auto p2 = _mm512_add_pd(
+        _mm512_add_pd(_mm512_mul_pd(x, x), _mm512_mul_pd(y, y)),
+        _mm512_mul_pd(z, z));
+
+    _mm512_storeu_pd(masses + j,
+                     _mm512_sqrt_pd(_mm512_sub_pd(_mm512_mul_pd(e, e), p2)));
+  }
+#endif
+
+#if defined(__AVX2__)
+  auto const px_v4 = _mm256_set1_pd(px);
+  auto const py_v4 = _mm256_set1_pd(py);
+  auto const pz_v4 = _mm256_set1_pd(pz);
+  auto const energy_v4 = _mm256_set1_pd(energy);
+
+  for (; j + 4 <= n; j += 4) {
+    auto x = _mm256_add_pd(px_v4, _mm256_loadu_pd(px_j + j));
+    auto y = _mm256_add_pd(py_v4, _mm256_loadu_pd(py_j + j));
+    auto z = _mm256_add_pd(pz_v4, _mm256_loadu_pd(pz_j + j));
+    auto e = _mm256_add_pd(energy_v4, _mm256_loadu_pd(energy_j + j));
+
+    auto p2 = _mm256_add_pd(
+        _mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y)),
+        _mm256_mul_pd(z, z));
+
+    _mm256_storeu_pd(masses + j,
+                     _mm256_sqrt_pd(_mm256_sub_pd(_mm256_mul_pd(e, e), p2)));
+  }
+#endif
+
+  // scalar fallback, also used for the remainder of the vector loops
+  for (; j < n; ++j) {
+    double x = px + px_j[j];
+    double y = py + py_j[j];
+    double z = pz + pz_j[j];
+    double e = energy + energy_j[j];
+
+    masses[j] = std::sqrt(e * e - (x * x + y * y + z * z));
+  }
+}
+
+void computeInvariantMasses(EventBuffer const& event, int i, double* masses) {
+  computeInvariantMasses(event.getPx()[i], event.getPy()[i], event.getPz()[i],
+                         event.getEnergy()[i], event.getPx(), event.getPy(),
+                         event.getPz(), event.getEnergy(), i, masses);
+}
@@ -0,0 +1,25 @@
+#ifndef INVARIANT_MASS_HPP
+#define INVARIANT_MASS_HPP
+
+class EventBuffer;
+
+/**
+ * Compute the invariant masses of one particle, given by its momentum and
+ * energy, paired with each of the n particles stored in the arrays. The masses
+ * are written in the same order to the masses array. The pairs are processed
+ * in AVX-512 or AVX2 lanes when the compiler targets those instruction sets,
+ * with a scalar loop otherwise. All the paths round the same way, so the
+ * results do not depend on the instruction set.
+ */
+void computeInvariantMasses(double px, double py, double pz, double energy,
+                            double const* px_j, double const* py_j,
+                            double const* pz_j, double const* energy_j, int n,
+                            double* masses);
+
+/**
+ * Compute the invariant masses of the i-th particle of the event paired with
+ * every particle that comes before it. masses must have room for i values.
+ */
+void computeInvariantMasses(EventBuffer const&, int i, double* masses);
+
+#endif
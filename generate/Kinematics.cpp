@@ -0,0 +1,45 @@
+#include "Kinematics.hpp"
+
+#include <cmath>
+
+#include "RandomEngine.hpp"
+
+void sampleMomenta(RandomEngine& engine, int n, double* p, double* theta,
+                   double* phi) {
+  engine.fillExp(p, n, 1.);  // GeV
+  engine.fillUniform(theta, n, 0., M_PI);
+  engine.fillUniform(phi, n, 0., 2. * M_PI);
+}
+
+void sphericalToCartesian(double const* p, double const* theta,
+                          double const* phi, int n, double* px, double* py,
+                          double* pz) {
+  // sin and cos of the same angle are next to each other, so the compiler
+  // merges them into a single sincos call. The libm calls are only turned into
+  // vector calls with -ffast-math, which would change the results
+  for (int i{}; i < n; ++i) {
+    double sin_theta = std::sin(theta[i]);
+    double cos_theta = std::cos(theta[i]);
+    double sin_phi = std::sin(phi[i]);
+    double cos_phi = std::cos(phi[i]);
+
+    px[i] = p[i] * sin_theta * cos_phi;
+    py[i] = p[i] * sin_theta * sin_phi;
+    pz[i] = p[i] * cos_theta;
+  }
+}
+
+void cartesianToSpherical(double const* px, double const* py,
+                          double const* pz, int n, double* p, double* theta,
+                          double* phi) {
+  for (int i{}; i < n; ++i) {
+    p[i] = std::sqrt(px[i] * px[i] + py[i] * py[i] + pz[i] * pz[i]);
+    theta[i] = std::acos(pz[i] / p[i]);
+    phi[i] = std::atan2(py[i], px[i]);
+  }
+
+  // kept apart from the libm calls so that this loop is vectorized
+  for (int i{}; i < n; ++i) {
+    phi[i] += (phi[i] < 0.) * M_PI * 2.;
+  }
+}
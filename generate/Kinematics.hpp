@@ -0,0 +1,31 @@
+#ifndef KINEMATICS_HPP
+#define KINEMATICS_HPP
+
+class RandomEngine;
+
+/**
+ * Draw the spherical momenta of n primary particles: the magnitude follows an
+ * exponential with mean 1 GeV, theta is uniform in [0, pi] and phi is uniform
+ * in [0, 2 pi]. Each array is filled in a single batch.
+ */
+void sampleMomenta(RandomEngine& engine, int n, double* p, double* theta,
+                   double* phi);
+
+/**
+ * Convert n momenta from spherical to cartesian coordinates, with the same
+ * rounding as the Momentum constructor that takes a PolarVector. The output
+ * arrays may point straight into the event storage.
+ */
+void sphericalToCartesian(double const* p, double const* theta,
+                          double const* phi, int n, double* px, double* py,
+                          double* pz);
+
+/**
+ * Convert n momenta from cartesian to spherical coordinates, with the same
+ * rounding as Momentum::getPolar. phi is in [0, 2 pi].
+ */
+void cartesianToSpherical(double const* px, double const* py,
+                          double const* pz, int n, double* p, double* theta,
+                          double* phi);
+
+#endif
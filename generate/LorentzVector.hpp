@@ -0,0 +1,46 @@
+#ifndef LORENTZ_VECTOR_HPP
+#define LORENTZ_VECTOR_HPP
+
+#include <cmath>
+
+// Four-momentum with the energy stored next to the momentum, so that it is
+// computed once from the mass instead of at every use
+struct LorentzVector {
+  double px;
+  double py;
+  double pz;
+  double energy;
+
+  static LorentzVector fromMass(double px, double py, double pz, double mass) {
+    return {px, py, pz,
+            std::sqrt(mass * mass + (px * px + py * py + pz * pz))};
+  }
+
+  double getMass() const {
+    return std::sqrt(energy * energy - (px * px + py * py + pz * pz));
+  }
+};
+
+/**
+ * Boost n four-vectors by the same velocity (bx, by, bz). gamma and the other
+ * factors that only depend on the velocity are computed once for the whole
+ * set, e.g. for all the products of a decay.
+ */
+inline void boostVectors(LorentzVector* vectors, int n, double bx, double by,
+                         double bz) {
+  double b2 = bx * bx + by * by + bz * bz;
+  double gamma = 1.0 / std::sqrt(1.0 - b2);
+  double gamma2 = b2 > 0 ? (gamma - 1.0) / b2 : 0.0;
+
+  for (int i{}; i < n; ++i) {
+    auto& v = vectors[i];
+    double bp = bx * v.px + by * v.py + bz * v.pz;
+
+    v.px += gamma2 * bp * bx + gamma * bx * v.energy;
+    v.py += gamma2 * bp * by + gamma * by * v.energy;
+    v.pz += gamma2 * bp * bz + gamma * bz * v.energy;
+    v.energy = gamma * (v.energy + bp);
+  }
+}
+
+#endif
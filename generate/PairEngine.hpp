@@ -0,0 +1,115 @@
+#ifndef PAIR_ENGINE_HPP
+#define PAIR_ENGINE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "InvariantMass.hpp"
+
+// Momenta and energies of the particles to be paired, as structure-of-arrays
+struct PairArrays {
+  int size;
+  double const* px;
+  double const* py;
+  double const* pz;
+  double const* energy;
+};
+
+// Visits all the pairs (i, j) with j < i of a set of particles, in square
+// tiles of tile_size x tile_size pairs. The particles of a tile fit in the L1
+// cache, so each of them is loaded from memory once per tile instead of once
+// per partner, which matters when events have thousands of particles.
+//
+// The pairs are passed to a function object in rows: function(i, j_begin, n,
+// masses) receives the invariant masses of i with j_begin, ..., j_begin + n -
+// 1. The function object is a template parameter, so the filling policy is
+// inlined in the loop. With a single tile (events smaller than tile_size) the
+// pairs are visited in the same order as the plain triangular loop.
+class PairEngine {
+ public:
+  PairEngine(int tile_size = 128)
+      : m_tile_size{tile_size}, m_masses(tile_size) {}
+
+  template <class PairFunction>
+  void run(PairArrays const& particles, PairFunction&& function) {
+    int n_tiles = mCountTiles(particles.size);
+
+    for (int i_tile{}; i_tile < n_tiles; ++i_tile) {
+      for (int j_tile{}; j_tile <= i_tile; ++j_tile) {
+        mRunTile(particles, i_tile, j_tile, m_masses.data(), function);
+      }
+    }
+  }
+
+  // the tiles are shared among one thread per function object, each filling
+  // its own function object. The caller merges them afterwards
+  template <class PairFunction>
+  void runParallel(PairArrays const& particles,
+                   std::vector<PairFunction>& functions) {
+    int n_tiles = mCountTiles(particles.size);
+    std::vector<std::pair<int, int>> tiles{};
+
+    for (int i_tile{}; i_tile < n_tiles; ++i_tile) {
+      for (int j_tile{}; j_tile <= i_tile; ++j_tile) {
+        tiles.emplace_back(i_tile, j_tile);
+      }
+    }
+
+    std::atomic<int> next_tile{0};
+    std::vector<std::thread> threads{};
+
+    for (auto& function : functions) {
+      threads.emplace_back([&, this] {
+        std::vector<double> masses(m_tile_size);
+
+        for (int tile = next_tile++; tile < static_cast<int>(tiles.size());
+             tile = next_tile++) {
+          mRunTile(particles, tiles[tile].first, tiles[tile].second,
+                   masses.data(), function);
+        }
+      });
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+ private:
+  int m_tile_size;
+  std::vector<double> m_masses;
+
+  int mCountTiles(int size) const {
+    return (size + m_tile_size - 1) / m_tile_size;
+  }
+
+  template <class PairFunction>
+  void mRunTile(PairArrays const& particles, int i_tile, int j_tile,
+                double* masses, PairFunction& function) const {
+    int i_begin = i_tile * m_tile_size;
+    int i_end = std::min(i_begin + m_tile_size, particles.size);
+    int j_begin = j_tile * m_tile_size;
+
+    for (int i{i_begin}; i < i_end; ++i) {
+      // on the diagonal tiles only the partners before i are paired
+      int j_end = std::min(j_begin + m_tile_size, i);
+
+      if (j_end <= j_begin) {
+        continue;
+      }
+
+      computeInvariantMasses(particles.px[i], particles.py[i], particles.pz[i],
+                             particles.energy[i], particles.px + j_begin,
+                             particles.py + j_begin, particles.pz + j_begin,
+                             particles.energy + j_begin, j_end - j_begin,
+                             masses);
+
+      function(i, j_begin, j_end - j_begin, masses);
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef PARSE_OPTION_HPP
+#define PARSE_OPTION_HPP
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <string>
+
+/**
+ * Helper function to parse the value of an integer option. Returns false if
+ * the text is not a whole number in the range of an int.
+ */
+inline bool parseInt(const char* text, int& value) {
+  char* end{nullptr};
+  errno = 0;
+  long parsed = std::strtol(text, &end, 10);
+
+  if (end == text || *end != '\0' || errno == ERANGE || parsed < INT_MIN ||
+      parsed > INT_MAX) {
+    return false;
+  }
+
+  value = parsed;
+  return true;
+}
+
+/**
+ * Helper function to parse the seed. Returns false if the text is not a whole
+ * non-negative number in the range of an unsigned int.
+ */
+inline bool parseSeed(const char* text, unsigned int& value) {
+  char* end{nullptr};
+  errno = 0;
+  unsigned long parsed = std::strtoul(text, &end, 10);
+
+  // strtoul accepts a sign and negates the value
+  if (end == text || *end != '\0' || errno == ERANGE || parsed > UINT_MAX ||
+      std::string{text}.find('-') != std::string::npos) {
+    return false;
+  }
+
+  value = parsed;
+  return true;
+}
+
+#endif
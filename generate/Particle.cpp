@@ -1,16 +1,38 @@
 #include "Particle.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <iostream>
 
+#include "LorentzVector.hpp"
 #include "ParticleType.hpp"
+#include "RandomEngine.hpp"
 #include "ResonanceType.hpp"
 #include "TMath.h"
 
 // init static members
 
 std::vector<std::unique_ptr<ParticleType>> Particle::m_particle_types{};
+std::atomic<long long> Particle::m_errors[Particle::N_ERRORS]{};
+
+/**
+ * Helper function to create the default random number engine of a thread. The
+ * threads take consecutive substreams of the default seed, in the order of
+ * their first decay, so that no two threads draw the same numbers.
+ */
+RandomEngine createThreadEngine() {
+  static std::atomic<int> n_threads{0};
+
+  RandomEngine engine{};
+  int thread = n_threads.fetch_add(1);
+
+  for (int t{}; t < thread; ++t) {
+    engine.jump();
+  }
+
+  return engine;
+}
 
 // momentum constructors
 
@@ -26,17 +48,11 @@ Momentum::Momentum(PolarVector const& polar)
 PolarVector Momentum::getPolar() const {
   double r = std::sqrt(x * x + y * y + z * z);
   double theta = std::acos(z / r);
-  double phi = std::atan(y / x);
-
-  // convert to the correct phi by adjusting the atan(y / x) result based on
-  // x and y coordinates
-  if (phi > 0 && x < 0) {
-    phi += TMath::Pi();
-  } else if (phi < 0 && x > 0) {
-    phi += TMath::Pi() * 2.;
-  } else if (phi < 0 && x < 0) {
-    phi += TMath::Pi();
-  }
+  double phi = std::atan2(y, x);
+
+  // atan2 returns values in [-pi, pi], move the negative ones to [pi, 2 pi]
+  // without branching on the quadrant
+  phi += (phi < 0.) * TMath::Pi() * 2.;
 
   return {r, theta, phi};
 };
@@ -73,8 +89,18 @@ void Particle::printData() const {
 }
 
 int Particle::decayToBody(Particle& dau1, Particle& dau2) const {
+  // every thread gets its own default engine, drawing from its own substream,
+  // so that concurrent decays never share a random number state or repeat the
+  // numbers of another thread
+  thread_local RandomEngine engine{createThreadEngine()};
+
+  return decayToBody(dau1, dau2, engine);
+}
+
+int Particle::decayToBody(Particle& dau1, Particle& dau2,
+                          RandomEngine& engine) const {
   if (getMass() == 0.0) {
-    printf("Decayment cannot be preformed if mass is zero\n");
+    mAddError(ZERO_MASS_DECAY);
     return 1;
   }
 
@@ -82,29 +108,16 @@ int Particle::decayToBody(Particle& dau1, Particle& dau2) const {
   double massDau1 = dau1.getMass();
   double massDau2 = dau2.getMass();
 
-  if (m_index != std::nullopt) {  // add width effect
-
-    // gaussian random numbers
-
-    float x1, x2, w, y1;
+  // draw the mass from the line shape of resonances
+  auto resonance =
+      dynamic_cast<ResonanceType const*>(m_particle_types[*m_index].get());
 
-    double invnum = 1. / RAND_MAX;
-    do {
-      x1 = 2.0 * std::rand() * invnum - 1.0;
-      x2 = 2.0 * std::rand() * invnum - 1.0;
-      w = x1 * x1 + x2 * x2;
-    } while (w >= 1.0);
-
-    w = std::sqrt((-2.0 * std::log(w)) / w);
-    y1 = x1 * w;
-
-    massMot += m_particle_types[m_index.value()]->getWidth() * y1;
+  if (resonance != nullptr) {
+    massMot = resonance->sampleMass(engine.uniform());
   }
 
   if (massMot < massDau1 + massDau2) {
-    printf(
-        "Decayment cannot be preformed because mass is too low in this "
-        "channel\n");
+    mAddError(LOW_MASS_DECAY);
     return 2;
   }
 
@@ -114,85 +127,50 @@ int Particle::decayToBody(Particle& dau1, Particle& dau2) const {
           (massMot * massMot - (massDau1 - massDau2) * (massDau1 - massDau2))) /
       massMot * 0.5;
 
-  double norm = 2 * M_PI / RAND_MAX;
+  double phi = engine.uniform(0., 2. * M_PI);
+  double theta = engine.uniform(-M_PI / 2., M_PI / 2.);
 
-  double phi = std::rand() * norm;
-  double theta = std::rand() * norm * 0.5 - M_PI / 2.;
-
-  dau1.setMomentum(pout * std::sin(theta) * std::cos(phi),
-                   pout * std::sin(theta) * std::sin(phi),
-                   pout * std::cos(theta));
-  dau2.setMomentum(-pout * std::sin(theta) * std::cos(phi),
-                   -pout * std::sin(theta) * std::sin(phi),
-                   -pout * std::cos(theta));
+  LorentzVector products[2]{
+      LorentzVector::fromMass(pout * std::sin(theta) * std::cos(phi),
+                              pout * std::sin(theta) * std::sin(phi),
+                              pout * std::cos(theta), massDau1),
+      LorentzVector::fromMass(-pout * std::sin(theta) * std::cos(phi),
+                              -pout * std::sin(theta) * std::sin(phi),
+                              -pout * std::cos(theta), massDau2)};
 
   double energy =
       std::sqrt(m_momentum.x * m_momentum.x + m_momentum.y * m_momentum.y +
                 m_momentum.z * m_momentum.z + massMot * massMot);
 
-  double bx = m_momentum.x / energy;
-  double by = m_momentum.y / energy;
-  double bz = m_momentum.z / energy;
+  // both products are boosted by the velocity of the mother in one go
+  boostVectors(products, 2, m_momentum.x / energy, m_momentum.y / energy,
+               m_momentum.z / energy);
 
-  dau1.boost(bx, by, bz);
-  dau2.boost(bx, by, bz);
+  dau1.setMomentum(products[0].px, products[0].py, products[0].pz);
+  dau2.setMomentum(products[1].px, products[1].py, products[1].pz);
 
   return 0;
 }
 
-// getters
-
-std::optional<int> Particle::getIndex() const { return m_index; }
-
-Momentum Particle::getMomentum() const { return m_momentum; }
+void Particle::boost(double bx, double by, double bz) {
+  LorentzVector vector{m_momentum.x, m_momentum.y, m_momentum.z, getEnergy()};
 
-double Particle::getEnergy() const {
-  if (m_index != std::nullopt) {
-    return std::sqrt(std::pow(m_particle_types[m_index.value()]->getMass(), 2) +
-                     m_momentum * m_momentum);
-  } else {
-    std::cout
-        << "ERROR: This particle has no energy because its index is invalid!"
-        << '\n';
+  boostVectors(&vector, 1, bx, by, bz);
 
-    return 0;
-  }
+  m_momentum = {vector.px, vector.py, vector.pz};
 }
 
-double Particle::getMass() const {
-  if (m_index != std::nullopt) {
-    return m_particle_types[m_index.value()]->getMass();
-  } else {
-    std::cout
-        << "ERROR: This particle has no mass because its index is invalid!"
-        << '\n';
-
-    return 0;
-  }
-}
+// getters
 
-double Particle::getCharge() const {
-  if (m_index != std::nullopt) {
-    return m_particle_types[m_index.value()]->getCharge();
-  } else {
-    std::cout
-        << "ERROR: This particle has no charge because its index is invalid!"
-        << '\n';
+std::string const& Particle::getName() const {
+  static std::string const no_name{};
 
-    return 0;
+  if (m_index == std::nullopt) {
+    mAddError(INVALID_INDEX);
+    return no_name;
   }
-}
-
-std::string Particle::getName() const {
-  if (m_index != std::nullopt) {
-    return m_particle_types[m_index.value()]->getName();
-  } else {
-    std::cout
-        << "ERROR: This particle has no name because its index is invalid!"
-        << '\n';
 
-    return "";
-  }
+  return m_particle_types[m_index.value()]->getName();
 }
 
 double Particle::getInvariantMass(Particle const& p) const {
@@ -228,7 +206,7 @@ void Particle::setMomentum(Momentum const& momentum) { m_momentum = momentum; }
 int Particle::countParticleTypes() { return m_particle_types.size(); }
 
 void Particle::addParticleType(std::string const& name, double mass, int charge,
-                               double width) {
+                               double width, LineShape line_shape) {
   auto existing_index = mFindParticleIndex(name);
 
   if (existing_index == std::nullopt) {
@@ -237,7 +215,7 @@ void Particle::addParticleType(std::string const& name, double mass, int charge,
           std::unique_ptr<ParticleType>{new ParticleType{name, mass, charge}});
     } else {
       m_particle_types.push_back(std::unique_ptr<ParticleType>{
-          new ResonanceType{name, mass, charge, width}});
+          new ResonanceType{name, mass, charge, width, line_shape}});
     }
   } else {
     std::cout << "ERROR: The \"" << name << "\" particle type already exists!"
@@ -245,6 +223,78 @@ void Particle::addParticleType(std::string const& name, double mass, int charge,
   }
 }
 
+void Particle::addDecayChannel(std::string const& name, double branching_ratio,
+                               std::vector<std::string> const& daughters) {
+  auto index = mFindParticleIndex(name);
+  ResonanceType* resonance{nullptr};
+
+  if (index != std::nullopt) {
+    resonance =
+        dynamic_cast<ResonanceType*>(m_particle_types[index.value()].get());
+  }
+
+  if (resonance == nullptr) {
+    std::cout << "ERROR: The \"" << name
+              << "\" particle type does not exist or is not a resonance!"
+              << '\n';
+    return;
+  }
+
+  if (daughters.size() < 2 || daughters.size() > MAX_DAUGHTERS) {
+    std::cout << "ERROR: Only decays into two or three particles are supported!"
+              << '\n';
+    return;
+  }
+
+  DecayChannel channel{branching_ratio, {}};
+  double threshold{};
+
+  for (auto const& daughter : daughters) {
+    auto daughter_index = mFindParticleIndex(daughter);
+
+    if (daughter_index == std::nullopt) {
+      std::cout << "ERROR: The \"" << daughter
+                << "\" particle type does not exist!" << '\n';
+      return;
+    }
+
+    channel.daughters.push_back(daughter_index.value());
+    threshold += m_particle_types[daughter_index.value()]->getMass();
+  }
+
+  resonance->addDecayChannel(channel, threshold);
+}
+
+ParticleType const* Particle::getParticleType(int index) {
+  if (index < 0 || index >= countParticleTypes()) {
+    return nullptr;
+  }
+
+  return m_particle_types[index].get();
+}
+
+long long Particle::countErrors(Error error) { return m_errors[error]; }
+
+void Particle::printErrors() {
+  char const* messages[N_ERRORS]{
+      "Particles with an invalid index read",
+      "Decays not performed because the mass is zero",
+      "Decays not performed because the mass is too low in the channel"};
+
+  for (int error{}; error < N_ERRORS; ++error) {
+    if (m_errors[error] > 0) {
+      std::cout << "ERROR: " << messages[error] << ": " << m_errors[error]
+                << '\n';
+    }
+  }
+}
+
+void Particle::resetErrors() {
+  for (auto& count : m_errors) {
+    count = 0;
+  }
+}
+
 void Particle::printParticleTypes() {
   auto v_end = m_particle_types.end();
 
@@ -275,16 +325,6 @@ std::optional<int> Particle::mFindParticleIndex(std::string const& name) {
   return std::distance(m_particle_types.begin(), it);
 }
 
-void Particle::boost(double bx, double by, double bz) {
-  double energy = getEnergy();
-
-  // Boost this Lorentz vector
-  double b2 = bx * bx + by * by + bz * bz;
-  double gamma = 1.0 / std::sqrt(1.0 - b2);
-  double bp = bx * m_momentum.x + by * m_momentum.y + bz * m_momentum.z;
-  double gamma2 = b2 > 0 ? (gamma - 1.0) / b2 : 0.0;
-
-  m_momentum.x += gamma2 * bp * bx + gamma * bx * energy;
-  m_momentum.y += gamma2 * bp * by + gamma * by * energy;
-  m_momentum.z += gamma2 * bp * bz + gamma * bz * energy;
-}
\ No newline at end of file
+void Particle::mAddError(Error error) {
+  m_errors[error].fetch_add(1, std::memory_order_relaxed);
+}
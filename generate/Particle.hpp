@@ -1,12 +1,17 @@
 #ifndef PARTICLE_HPP
 #define PARTICLE_HPP
 
+#include <atomic>
+#include <cmath>
 #include <memory>
 #include <optional>
 #include <string>
 #include <vector>
 
-class ParticleType;
+#include "ParticleType.hpp"
+#include "ResonanceType.hpp"
+
+class RandomEngine;
 
 struct PolarVector {
   double r;
@@ -29,11 +34,16 @@ struct Momentum {
 
 class Particle {
  public:
+  // errors are counted instead of printed, so that getters and decays never
+  // write to the output while generating. printErrors reports the tally once
+  enum Error { INVALID_INDEX, ZERO_MASS_DECAY, LOW_MASS_DECAY, N_ERRORS };
+
   Particle(std::string const& = "", Momentum const& = {0., 0., 0.});
 
   void printData() const;
 
   int decayToBody(Particle&, Particle&) const;
+  int decayToBody(Particle&, Particle&, RandomEngine&) const;
 
   // setters
 
@@ -49,14 +59,27 @@ class Particle {
   double getEnergy() const;
   double getMass() const;
   double getCharge() const;
-  std::string getName() const;
+  std::string const& getName() const;
   double getInvariantMass(Particle const&) const;
 
+  // getters without the index check, for particles known to have a valid
+  // index
+  double getEnergyUnchecked() const;
+  double getMassUnchecked() const;
+  double getChargeUnchecked() const;
+
   // static methods
 
   static int countParticleTypes();
-  static void addParticleType(std::string const&, double, int, double = 0.);
+  static void addParticleType(std::string const&, double, int, double = 0.,
+                              LineShape = GAUSSIAN);
+  static void addDecayChannel(std::string const&, double,
+                              std::vector<std::string> const&);
+  static ParticleType const* getParticleType(int);
   static void printParticleTypes();
+  static long long countErrors(Error);
+  static void printErrors();
+  static void resetErrors();
 
  private:
   Momentum m_momentum;
@@ -65,7 +88,59 @@ class Particle {
   void boost(double, double, double);
 
   static std::vector<std::unique_ptr<ParticleType>> m_particle_types;
+  static std::atomic<long long> m_errors[N_ERRORS];
+
   static std::optional<int> mFindParticleIndex(std::string const&);
+  static void mAddError(Error);
+
+  // the decay engine performs the same decays as decayToBody and counts its
+  // errors in the same tally
+  friend class DecayEngine;
 };
 
+// inline getters
+
+inline std::optional<int> Particle::getIndex() const { return m_index; }
+
+inline Momentum Particle::getMomentum() const { return m_momentum; }
+
+inline double Particle::getEnergy() const {
+  if (m_index == std::nullopt) {
+    mAddError(INVALID_INDEX);
+    return 0;
+  }
+
+  return getEnergyUnchecked();
+}
+
+inline double Particle::getMass() const {
+  if (m_index == std::nullopt) {
+    mAddError(INVALID_INDEX);
+    return 0;
+  }
+
+  return getMassUnchecked();
+}
+
+inline double Particle::getCharge() const {
+  if (m_index == std::nullopt) {
+    mAddError(INVALID_INDEX);
+    return 0;
+  }
+
+  return getChargeUnchecked();
+}
+
+inline double Particle::getEnergyUnchecked() const {
+  return std::sqrt(std::pow(getMassUnchecked(), 2) + m_momentum * m_momentum);
+}
+
+inline double Particle::getMassUnchecked() const {
+  return m_particle_types[*m_index]->getMass();
+}
+
+inline double Particle::getChargeUnchecked() const {
+  return m_particle_types[*m_index]->getCharge();
+}
+
 #endif
\ No newline at end of file
@@ -9,12 +9,6 @@ ParticleType::ParticleType(std::string const& name, double mass, int charge)
 
 // public methods
 
-std::string ParticleType::getName() const { return m_name; }
-
-double ParticleType::getMass() const { return m_mass; }
-
-int ParticleType::getCharge() const { return m_charge; }
-
 double ParticleType::getWidth() const { return 0.; }
 
 void ParticleType::print() const {
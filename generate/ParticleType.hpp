@@ -8,9 +8,9 @@ class ParticleType {
   ParticleType(std::string const&, double, int);
   virtual ~ParticleType() = default;
 
-  std::string getName() const;
-  double getMass() const;
-  int getCharge() const;
+  std::string const& getName() const { return m_name; }
+  double getMass() const { return m_mass; }
+  int getCharge() const { return m_charge; }
   virtual double getWidth() const;
   virtual void print() const;
 
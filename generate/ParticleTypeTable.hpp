@@ -0,0 +1,149 @@
+#ifndef PARTICLE_TYPE_TABLE_HPP
+#define PARTICLE_TYPE_TABLE_HPP
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "Particle.hpp"
+
+// Integer ids of the particle types used by the generator. They are
+// registered in this order, so each id is also the index of the type inside
+// the Particle type table.
+enum ParticleTypeId : int {
+  PION_PLUS,
+  PION_MINUS,
+  KAON_PLUS,
+  KAON_MINUS,
+  PROTON_PLUS,
+  PROTON_MINUS,
+  K_STAR,
+  N_PARTICLE_TYPES
+};
+
+struct ParticleTypeEntry {
+  char const* name;
+  double mass;  // GeV/c^2
+  int charge;
+  double width;  // GeV/c^2
+  bool is_pion;
+  bool is_kaon;
+};
+
+constexpr std::array<ParticleTypeEntry, N_PARTICLE_TYPES> PARTICLE_TYPE_TABLE{{
+    {"pion+", 0.13957, 1, 0., true, false},
+    {"pion-", 0.13957, -1, 0., true, false},
+    {"kaon+", 0.49367, 1, 0., false, true},
+    {"kaon-", 0.49367, -1, 0., false, true},
+    {"proton+", 0.93827, 1, 0., false, false},
+    {"proton-", 0.93827, -1, 0., false, false},
+    {"k*", 0.89166, 0, 0.050, false, false},
+}};
+
+struct DecayChannelEntry {
+  ParticleTypeId resonance;
+  double branching_ratio;
+  std::array<ParticleTypeId, 3> daughters;
+  int n_daughters;
+};
+
+// decay channels of the built-in resonances
+constexpr std::array<DecayChannelEntry, 2> DECAY_CHANNEL_TABLE{{
+    {K_STAR, 0.5, {PION_PLUS, KAON_MINUS}, 2},
+    {K_STAR, 0.5, {PION_MINUS, KAON_PLUS}, 2},
+}};
+
+// Bit flags telling which invariant mass histograms a pair belongs to
+enum PairClass : unsigned {
+  OPPOSITE_CHARGE = 1u << 0,
+  SAME_CHARGE = 1u << 1,
+  PION_KAON_OPPOSITE = 1u << 2,
+  PION_KAON_SAME = 1u << 3
+};
+
+// Bit flags describing a single particle, combined into the class of a pair
+enum ParticleClass : unsigned {
+  POSITIVE = 1u << 0,
+  NEGATIVE = 1u << 1,
+  PION = 1u << 2,
+  KAON = 1u << 3
+};
+
+/**
+ * Class mask of a particle from its type and charge. Types added with
+ * Particle::addParticleType only get the charge bits.
+ */
+inline unsigned getParticleClass(int type_id, int charge) {
+  unsigned particle_class = (charge > 0 ? POSITIVE : 0u) |
+                            (charge < 0 ? NEGATIVE : 0u);
+
+  if (static_cast<unsigned>(type_id) < N_PARTICLE_TYPES) {
+    auto const& type = PARTICLE_TYPE_TABLE[type_id];
+    particle_class |= (type.is_pion ? PION : 0u) | (type.is_kaon ? KAON : 0u);
+  }
+
+  return particle_class;
+}
+
+/**
+ * Class of a pair, as PairClass flags, from the class masks of its particles.
+ * Swapping the positive and negative bits and the pion and kaon bits of the
+ * second mask turns "one is X and the other is Y" into a single and.
+ */
+constexpr unsigned getPairClass(unsigned class_1, unsigned class_2) {
+  unsigned swapped_2 = ((class_2 & (POSITIVE | PION)) << 1) |
+                       ((class_2 & (NEGATIVE | KAON)) >> 1);
+  unsigned common = class_1 & class_2;
+  unsigned crossed = class_1 & swapped_2;
+
+  bool opposite_charge = crossed & (POSITIVE | NEGATIVE);
+  bool same_charge = common & (POSITIVE | NEGATIVE);
+  bool pion_kaon = crossed & (PION | KAON);
+
+  return (opposite_charge ? OPPOSITE_CHARGE : 0u) |
+         (same_charge ? SAME_CHARGE : 0u) |
+         (pion_kaon && opposite_charge ? PION_KAON_OPPOSITE : 0u) |
+         (pion_kaon && same_charge ? PION_KAON_SAME : 0u);
+}
+
+/**
+ * Add the built-in particle types and their decay channels to the Particle
+ * type table. Returns false if any of them did not end up at the index
+ * matching its ParticleTypeId, which happens when other types were added
+ * before.
+ */
+inline bool registerParticleTypes() {
+  bool ids_match = true;
+  bool added[N_PARTICLE_TYPES]{};
+
+  for (int id{}; id < N_PARTICLE_TYPES; ++id) {
+    auto const& type = PARTICLE_TYPE_TABLE[id];
+
+    if (Particle::countParticleTypes() == id) {
+      Particle::addParticleType(type.name, type.mass, type.charge, type.width);
+      added[id] = true;
+    }
+
+    auto index = Particle{type.name}.getIndex();
+    ids_match = ids_match && index != std::nullopt && index.value() == id;
+  }
+
+  // the channels are only added together with their resonance, so that calling
+  // this function again does not duplicate them
+  for (auto const& channel : DECAY_CHANNEL_TABLE) {
+    if (added[channel.resonance]) {
+      std::vector<std::string> daughters{};
+
+      for (int i{}; i < channel.n_daughters; ++i) {
+        daughters.push_back(PARTICLE_TYPE_TABLE[channel.daughters[i]].name);
+      }
+
+      Particle::addDecayChannel(PARTICLE_TYPE_TABLE[channel.resonance].name,
+                                channel.branching_ratio, daughters);
+    }
+  }
+
+  return ids_match;
+}
+
+#endif
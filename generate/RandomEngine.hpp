@@ -0,0 +1,136 @@
+#ifndef RANDOM_ENGINE_HPP
+#define RANDOM_ENGINE_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// xoshiro256** pseudo-random number generator (Blackman and Vigna). The state
+// is only 32 bytes and every instance is independent, so each thread can own
+// its engine. Engines seeded with the same value and jumped a different number
+// of times produce non-overlapping streams of 2^128 numbers each.
+class RandomEngine {
+ public:
+  using result_type = std::uint64_t;
+
+  explicit RandomEngine(std::uint64_t seed = 4357) { setSeed(seed); }
+
+  void setSeed(std::uint64_t seed) {
+    // expand the seed with splitmix64, as recommended by the authors
+    for (auto& s : m_state) {
+      seed += 0x9e3779b97f4a7c15;
+      std::uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+      s = z ^ (z >> 31);
+    }
+  }
+
+  // raw 64 bit output, so that the engine can be used with <random>
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() {
+    auto const result = mRotl(m_state[1] * 5, 7) * 9;
+    auto const t = m_state[1] << 17;
+
+    m_state[2] ^= m_state[0];
+    m_state[3] ^= m_state[1];
+    m_state[1] ^= m_state[2];
+    m_state[0] ^= m_state[3];
+    m_state[2] ^= t;
+    m_state[3] = mRotl(m_state[3], 45);
+
+    return result;
+  }
+
+  // uniform in [0, 1), built from the 53 most significant bits
+  double uniform() { return ((*this)() >> 11) * 0x1.0p-53; }
+
+  double uniform(double low, double high) {
+    return low + (high - low) * uniform();
+  }
+
+  // exponential with mean tau
+  double exp(double tau) { return -tau * std::log1p(-uniform()); }
+
+  // gaussian from the Box-Muller transform. Unlike the polar method it draws
+  // exactly two numbers per call
+  double gaus(double mean = 0., double sigma = 1.) {
+    double u1 = 1. - uniform();
+    double u2 = uniform();
+
+    return mean + sigma * std::sqrt(-2. * std::log(u1)) *
+                      std::cos(2. * M_PI * u2);
+  }
+
+  // batched draws
+
+  void fillUniform(double* values, int n, double low = 0., double high = 1.) {
+    for (int i{}; i < n; ++i) {
+      values[i] = uniform();
+    }
+
+    for (int i{}; i < n; ++i) {
+      values[i] = low + (high - low) * values[i];
+    }
+  }
+
+  void fillExp(double* values, int n, double tau) {
+    for (int i{}; i < n; ++i) {
+      values[i] = uniform();
+    }
+
+    for (int i{}; i < n; ++i) {
+      values[i] = -tau * std::log1p(-values[i]);
+    }
+  }
+
+  void fillGaus(double* values, int n, double mean = 0., double sigma = 1.) {
+    for (int i{}; i < n; ++i) {
+      values[i] = gaus(mean, sigma);
+    }
+  }
+
+  // advance the engine by 2^128 steps, used to split a seed into substreams
+  void jump() {
+    constexpr std::uint64_t jump_polynomial[]{
+        0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa,
+        0x39abdc4529b1661c};
+
+    std::uint64_t state[4]{};
+
+    for (auto word : jump_polynomial) {
+      for (int b{}; b < 64; ++b) {
+        if (word & std::uint64_t{1} << b) {
+          for (int i{}; i < 4; ++i) {
+            state[i] ^= m_state[i];
+          }
+        }
+
+        (*this)();
+      }
+    }
+
+    for (int i{}; i < 4; ++i) {
+      m_state[i] = state[i];
+    }
+  }
+
+  // passes the state to archive, which saves or restores it
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(m_state, 4);
+  }
+
+ private:
+  std::uint64_t m_state[4];
+
+  static std::uint64_t mRotl(std::uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+};
+
+#endif
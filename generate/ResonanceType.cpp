@@ -1,18 +1,146 @@
 #include "ResonanceType.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 // constructor
 ResonanceType::ResonanceType(std::string const& name, double mass, int charge,
-                             double width)
-    : ParticleType{name, mass, charge}, m_width{width} {}
+                             double width, LineShape line_shape)
+    : ParticleType{name, mass, charge},
+      m_width{width},
+      m_line_shape{line_shape},
+      m_threshold{0.} {
+  mBuildMassTable();
+}
 
 // public methods
 double ResonanceType::getWidth() const { return m_width; }
 
 void ResonanceType::print() const {
+  char const* line_shapes[]{"Gaussian", "Breit-Wigner",
+                            "relativistic Breit-Wigner"};
+
   std::cout << "Name: " << getName() << '\n'
             << "Mass: " << getMass() << '\n'
             << "Charge: " << getCharge() << '\n'
-            << "Width: " << m_width << '\n';
-}
\ No newline at end of file
+            << "Width: " << m_width << '\n'
+            << "Line shape: " << line_shapes[m_line_shape] << '\n';
+
+  for (auto const& channel : m_decay_channels) {
+    std::cout << "Decay channel: " << channel.branching_ratio << " ->";
+
+    for (int daughter : channel.daughters) {
+      std::cout << ' ' << daughter;
+    }
+
+    std::cout << '\n';
+  }
+}
+
+// threshold is the sum of the masses of the daughters
+void ResonanceType::addDecayChannel(DecayChannel const& channel,
+                                    double threshold) {
+  int n_daughters = channel.daughters.size();
+
+  if (n_daughters < 2 || n_daughters > MAX_DAUGHTERS) {
+    std::cout << "ERROR: Only decays into two or three particles are supported!"
+              << '\n';
+    return;
+  }
+
+  m_decay_channels.push_back(channel);
+
+  if (threshold > m_threshold) {
+    m_threshold = threshold;
+    mBuildMassTable();
+  }
+}
+
+std::vector<DecayChannel> const& ResonanceType::getDecayChannels() const {
+  return m_decay_channels;
+}
+
+LineShape ResonanceType::getLineShape() const { return m_line_shape; }
+
+double ResonanceType::getThreshold() const { return m_threshold; }
+
+std::vector<double> const& ResonanceType::getMassTable() const {
+  return m_mass_table;
+}
+
+// u is a uniform number in [0, 1)
+double ResonanceType::sampleMass(double u) const {
+  return interpolateMassTable(m_mass_table.data(), u);
+}
+
+// private methods
+
+// line shape up to a constant factor
+double ResonanceType::mLineShape(double mass) const {
+  double m0 = getMass();
+
+  switch (m_line_shape) {
+    case BREIT_WIGNER:
+      return 1. / ((mass - m0) * (mass - m0) + m_width * m_width / 4.);
+    case RELATIVISTIC_BREIT_WIGNER:
+      return mass * m0 * m_width /
+             ((mass * mass - m0 * m0) * (mass * mass - m0 * m0) +
+              m0 * m0 * m_width * m_width);
+    default:
+      return std::exp(-0.5 * (mass - m0) * (mass - m0) / (m_width * m_width));
+  }
+}
+
+// tabulates the inverse of the cumulative distribution of the line shape,
+// between the threshold and 10 widths around the nominal mass. The
+// distribution is integrated with the trapezoidal rule on a grid much finer
+// than the table
+void ResonanceType::mBuildMassTable() {
+  double low = std::max({m_threshold, getMass() - 10. * m_width, 0.});
+  double high = getMass() + 10. * m_width;
+
+  // a channel whose threshold is above the whole line shape can only decay
+  // resonances at the threshold
+  bool closed = m_width > 0. ? m_threshold >= high : m_threshold > getMass();
+
+  if (closed) {
+    std::cout << "ERROR: The threshold of the decay channels of \"" << getName()
+              << "\" is above its line shape!" << '\n';
+  }
+
+  if (m_width <= 0. || high <= low) {
+    m_mass_table.assign(MASS_TABLE_POINTS, std::max(getMass(), m_threshold));
+    return;
+  }
+
+  int const n_steps = 64 * (MASS_TABLE_POINTS - 1);
+  double step = (high - low) / n_steps;
+  std::vector<double> cumulative(n_steps + 1);
+  double previous = mLineShape(low);
+
+  for (int i{1}; i <= n_steps; ++i) {
+    double current = mLineShape(low + i * step);
+    cumulative[i] = cumulative[i - 1] + 0.5 * (previous + current) * step;
+    previous = current;
+  }
+
+  m_mass_table.resize(MASS_TABLE_POINTS);
+  m_mass_table.front() = low;
+  m_mass_table.back() = high;
+
+  int i{};
+
+  for (int point{1}; point < MASS_TABLE_POINTS - 1; ++point) {
+    double target = cumulative[n_steps] * point / (MASS_TABLE_POINTS - 1);
+
+    while (cumulative[i + 1] < target) {
+      ++i;
+    }
+
+    // linear inside the step
+    double fraction =
+        (target - cumulative[i]) / (cumulative[i + 1] - cumulative[i]);
+    m_mass_table[point] = low + (i + fraction) * step;
+  }
+}
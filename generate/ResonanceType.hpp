@@ -1,18 +1,70 @@
 #ifndef RESONANCE_TYPE_HPP
 #define RESONANCE_TYPE_HPP
 
+#include <vector>
+
 #include "ParticleType.hpp"
 
+// maximum number of particles a resonance decays into
+constexpr int MAX_DAUGHTERS = 3;
+
+// A decay mode of a resonance: the fraction of its decays that go through this
+// channel and the indices of the particle types it decays into, from two to
+// MAX_DAUGHTERS of them
+struct DecayChannel {
+  double branching_ratio;
+  std::vector<int> daughters;
+};
+
+// Distribution of the mass of a resonance around its nominal mass. For the
+// Gaussian the width is the standard deviation, for the Breit-Wigner shapes it
+// is the full width at half maximum
+enum LineShape : int { GAUSSIAN, BREIT_WIGNER, RELATIVISTIC_BREIT_WIGNER };
+
+// number of points of the inverse cumulative distribution tables
+constexpr int MASS_TABLE_POINTS = 1025;
+
+/**
+ * Mass at the u-th quantile of a line shape, interpolated linearly between the
+ * MASS_TABLE_POINTS masses of table, which sit at equally spaced quantiles.
+ * u must be in [0, 1).
+ */
+inline double interpolateMassTable(double const* table, double u) {
+  double x = u * (MASS_TABLE_POINTS - 1);
+  int i = static_cast<int>(x);
+
+  return table[i] + (x - i) * (table[i + 1] - table[i]);
+}
+
 class ResonanceType : public ParticleType {
  public:
-  ResonanceType(std::string const&, double, int, double);
+  ResonanceType(std::string const&, double, int, double,
+                LineShape = GAUSSIAN);
   ~ResonanceType() override = default;
 
   double getWidth() const override;
   void print() const override;
 
+  void addDecayChannel(DecayChannel const&, double);
+  std::vector<DecayChannel> const& getDecayChannels() const;
+
+  LineShape getLineShape() const;
+  double getThreshold() const;
+  std::vector<double> const& getMassTable() const;
+  double sampleMass(double) const;
+
  private:
   double const m_width;
+  LineShape const m_line_shape;
+  std::vector<DecayChannel> m_decay_channels;
+
+  // the line shape is truncated below the threshold of the heaviest channel,
+  // so that every channel is open for any sampled mass
+  double m_threshold;
+  std::vector<double> m_mass_table;
+
+  double mLineShape(double) const;
+  void mBuildMassTable();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,109 @@
+#include "SpeciesSampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "RandomEngine.hpp"
+
+// constructor
+
+SpeciesSampler::SpeciesSampler(std::vector<SpeciesAbundance> const& abundances)
+    : m_type_ids(abundances.size()),
+      m_thresholds(abundances.size(), 1.),
+      m_aliases(abundances.size()) {
+  int n = abundances.size();
+  double total{};
+
+  for (auto const& abundance : abundances) {
+    if (!(abundance.probability >= 0.) || std::isinf(abundance.probability)) {
+      total = 0.;
+      break;
+    }
+
+    total += abundance.probability;
+  }
+
+  if (!(total > 0.) || std::isinf(total)) {
+    std::cout << "ERROR: The species abundances must be finite and not "
+                 "negative, and at least one must be positive!"
+              << '\n';
+
+    m_type_ids.clear();
+    m_thresholds.clear();
+    m_aliases.clear();
+    return;
+  }
+
+  // scale the probabilities so that their mean is 1, then pair every species
+  // below the mean with one above it (Vose's construction)
+  std::vector<double> scaled(n);
+  std::vector<int> small{};
+  std::vector<int> large{};
+
+  for (int i{}; i < n; ++i) {
+    m_type_ids[i] = abundances[i].type_id;
+    m_aliases[i] = i;
+    scaled[i] = abundances[i].probability * n / total;
+
+    if (scaled[i] < 1.) {
+      small.push_back(i);
+    } else {
+      large.push_back(i);
+    }
+  }
+
+  while (!small.empty() && !large.empty()) {
+    int s = small.back();
+    int l = large.back();
+    small.pop_back();
+
+    m_thresholds[s] = scaled[s];
+    m_aliases[s] = l;
+    scaled[l] -= 1. - scaled[s];
+
+    if (scaled[l] < 1.) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+
+  // whatever is left is 1 up to rounding errors, and keeps threshold 1
+}
+
+// public methods
+
+int SpeciesSampler::sample(RandomEngine& engine) const {
+  if (m_type_ids.empty()) {
+    return -1;
+  }
+
+  double u = engine.uniform() * m_type_ids.size();
+  int column = static_cast<int>(u);
+
+  return u - column < m_thresholds[column] ? m_type_ids[column]
+                                           : m_type_ids[m_aliases[column]];
+}
+
+void SpeciesSampler::sampleN(RandomEngine& engine, int* type_ids,
+                             int n) const {
+  int const n_columns = m_type_ids.size();
+
+  if (n_columns == 0) {
+    std::fill(type_ids, type_ids + n, -1);
+    return;
+  }
+
+  for (int i{}; i < n; ++i) {
+    double u = engine.uniform() * n_columns;
+    int column = static_cast<int>(u);
+
+    type_ids[i] = u - column < m_thresholds[column]
+                      ? m_type_ids[column]
+                      : m_type_ids[m_aliases[column]];
+  }
+}
+
+// getters
+
+int SpeciesSampler::size() const { return m_type_ids.size(); }
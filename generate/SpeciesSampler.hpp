@@ -0,0 +1,35 @@
+#ifndef SPECIES_SAMPLER_HPP
+#define SPECIES_SAMPLER_HPP
+
+#include <vector>
+
+class RandomEngine;
+
+struct SpeciesAbundance {
+  int type_id;
+  double probability;
+};
+
+/**
+ * Draws particle type ids with the given abundances using Walker's alias
+ * method: every draw costs one uniform number, one table lookup and one
+ * comparison, however many species there are. The probabilities do not need
+ * to be normalized, but must not be negative and must not all be zero. A
+ * sampler built from invalid abundances is empty and draws -1.
+ */
+class SpeciesSampler {
+ public:
+  SpeciesSampler(std::vector<SpeciesAbundance> const&);
+
+  int sample(RandomEngine&) const;
+  void sampleN(RandomEngine&, int*, int) const;
+
+  int size() const;
+
+ private:
+  std::vector<int> m_type_ids;
+  std::vector<double> m_thresholds;
+  std::vector<int> m_aliases;
+};
+
+#endif
@@ -0,0 +1,349 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DecayEngine.hpp"
+#include "EventBuffer.hpp"
+#include "InvariantMass.hpp"
+#include "Kinematics.hpp"
+#include "LorentzVector.hpp"
+#include "PairEngine.hpp"
+#include "Particle.hpp"
+#include "ParticleTypeTable.hpp"
+#include "RandomEngine.hpp"
+#include "TH1.h"
+#include "generate.hpp"
+
+// Result of a single benchmark. ns_per_op is the time per call of the timed
+// function, items_per_s counts events or pairs depending on the benchmark
+struct BenchmarkResult {
+  std::string name;
+  long long n_ops;
+  double ns_per_op;
+  std::string item;
+  double items_per_s;
+};
+
+// keeps the compiler from optimizing away the benchmarked computations
+volatile double g_sink{};
+
+/**
+ * Time n_ops calls of op, after a warm-up run of a tenth of them.
+ * items_per_op is the number of items (events, pairs) processed by each call.
+ */
+template <class Op>
+BenchmarkResult runBenchmark(std::string const& name, long long n_ops, Op op,
+                             std::string const& item = "",
+                             double items_per_op = 0.) {
+  for (long long i{}; i < n_ops / 10; ++i) {
+    op(i);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (long long i{}; i < n_ops; ++i) {
+    op(i);
+  }
+
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  double ns_per_op = elapsed.count() / n_ops;
+  double items_per_s = items_per_op > 0. ? items_per_op / ns_per_op * 1e9 : 0.;
+
+  return {name, n_ops, ns_per_op, item, items_per_s};
+}
+
+void printTable(std::vector<BenchmarkResult> const& results) {
+  for (auto const& result : results) {
+    std::cout << result.name << ": " << result.ns_per_op << " ns/op";
+
+    if (!result.item.empty()) {
+      std::cout << ", " << result.items_per_s << ' ' << result.item << "/s";
+    }
+
+    std::cout << '\n';
+  }
+}
+
+void printJson(std::vector<BenchmarkResult> const& results) {
+  std::cout << "[\n";
+
+  for (std::size_t i{}; i < results.size(); ++i) {
+    auto const& result = results[i];
+
+    std::cout << "  {\"name\": \"" << result.name
+              << "\", \"ops\": " << result.n_ops
+              << ", \"ns_per_op\": " << result.ns_per_op;
+
+    if (!result.item.empty()) {
+      std::cout << ", \"" << result.item << "_per_s\": " << result.items_per_s;
+    }
+
+    std::cout << (i + 1 < results.size() ? "},\n" : "}\n");
+  }
+
+  std::cout << "]\n";
+}
+
+int main(int argc, char** argv) {
+  bool json = argc > 1 && std::strcmp(argv[1], "--json") == 0;
+
+  registerParticleTypes();
+  TH1::AddDirectory(kFALSE);
+
+  RandomEngine rng{42};
+  std::vector<BenchmarkResult> results{};
+
+  // random sample of 100 primary particles, shared by the single particle and
+  // the pair benchmarks
+  int const n_particles = 100;
+  std::vector<Particle> particles{};
+  EventBuffer event{};
+
+  for (int i{}; i < n_particles; ++i) {
+    Momentum momentum{PolarVector{rng.exp(1.), rng.uniform(0., M_PI),
+                                  rng.uniform(0., 2. * M_PI)}};
+    particles.emplace_back(PARTICLE_TYPE_TABLE[i % K_STAR].name, momentum);
+    event.push(particles.back());
+  }
+
+  Particle particle{};
+
+  results.push_back(
+      runBenchmark("setIndex(string)", 10000000, [&](long long i) {
+        particle.setIndex(PARTICLE_TYPE_TABLE[i % N_PARTICLE_TYPES].name);
+      }));
+
+  SpeciesSampler species{PRIMARY_ABUNDANCES};
+  std::vector<int> type_ids(n_particles);
+
+  results.push_back(runBenchmark(
+      "SpeciesSampler::sampleN", 100000,
+      [&](long long) {
+        species.sampleN(rng, type_ids.data(), n_particles);
+        g_sink = type_ids[0];
+      },
+      "particles", n_particles));
+
+  std::vector<double> p(n_particles);
+  std::vector<double> theta(n_particles);
+  std::vector<double> phi(n_particles);
+  EventBuffer primaries{};
+
+  results.push_back(runBenchmark(
+      "primary kinematics", 100000,
+      [&](long long) {
+        sampleMomenta(rng, n_particles, p.data(), theta.data(), phi.data());
+        primaries.setPrimaries(n_particles, type_ids.data(), p.data(),
+                               theta.data(), phi.data());
+        g_sink = primaries.getPx()[0];
+      },
+      "particles", n_particles));
+
+  results.push_back(runBenchmark("setIndex(int)", 10000000, [&](long long i) {
+    particle.setIndex(static_cast<int>(i % N_PARTICLE_TYPES));
+  }));
+
+  Particle k_star{"k*", {0.3, -0.2, 1.1}};
+  Particle pion{"pion+"};
+  Particle kaon{"kaon-"};
+
+  results.push_back(runBenchmark("decayToBody", 2000000, [&](long long) {
+    k_star.decayToBody(pion, kaon, rng);
+    g_sink = pion.getMomentum().x;
+  }));
+
+  // a single particle, the way Particle boosts its own momentum
+  results.push_back(
+      runBenchmark("boostVectors (1 vector)", 10000000, [&](long long i) {
+        auto vector = LorentzVector::fromMass(
+            0.5, -0.3, 0.2, particles[i % n_particles].getMassUnchecked());
+
+        boostVectors(&vector, 1, 0.1, 0.2, -0.3);
+        g_sink = vector.pz;
+      }));
+
+  // the two products of a decay, boosted together
+  results.push_back(
+      runBenchmark("boostVectors (2 products)", 10000000, [&](long long) {
+        LorentzVector products[2]{
+            LorentzVector::fromMass(0.5, -0.3, 0.2, 0.13957),
+            LorentzVector::fromMass(-0.5, 0.3, -0.2, 0.49367)};
+
+        boostVectors(products, 2, 0.1, 0.2, -0.3);
+        g_sink = products[1].pz;
+      }));
+
+  results.push_back(
+      runBenchmark("Momentum::getPolar", 10000000, [&](long long i) {
+        auto polar = particles[i % n_particles].getMomentum().getPolar();
+        g_sink = polar.phi;
+      }));
+
+  results.push_back(runBenchmark(
+      "cartesianToSpherical", 100000,
+      [&](long long) {
+        cartesianToSpherical(event.getPx(), event.getPy(), event.getPz(),
+                             n_particles, p.data(), theta.data(), phi.data());
+        g_sink = phi[0];
+      },
+      "particles", n_particles));
+
+  results.push_back(runBenchmark(
+      "getInvariantMass", 10000000,
+      [&](long long i) {
+        auto const& p1 = particles[i % n_particles];
+        auto const& p2 = particles[(i * 7 + 3) % n_particles];
+        g_sink = p1.getInvariantMass(p2);
+      },
+      "pairs", 1.));
+
+  // all the pairs of a 100 particle event, through the objects and through
+  // the structure-of-arrays kernel
+  double const n_pairs = n_particles * (n_particles - 1) / 2.;
+  std::vector<double> masses(n_particles);
+
+  results.push_back(runBenchmark(
+      "pair loop (Particle)", 20000,
+      [&](long long) {
+        double sum{};
+
+        for (int i{1}; i < n_particles; ++i) {
+          for (int j{}; j < i; ++j) {
+            sum += particles[i].getInvariantMass(particles[j]);
+          }
+        }
+
+        g_sink = sum;
+      },
+      "pairs", n_pairs));
+
+  results.push_back(runBenchmark(
+      "pair loop (EventBuffer)", 20000,
+      [&](long long) {
+        double sum{};
+
+        for (int i{1}; i < n_particles; ++i) {
+          computeInvariantMasses(event, i, masses.data());
+
+          for (int j{}; j < i; ++j) {
+            sum += masses[j];
+          }
+        }
+
+        g_sink = sum;
+      },
+      "pairs", n_pairs));
+
+  // pairs of a heavy-ion sized event, through the plain triangular loop and
+  // through the tiled engine, serial and with one thread per core
+  int const n_large = 4000;
+  double const n_large_pairs = n_large * (n_large - 1) / 2.;
+  EventBuffer large_event{n_large};
+
+  for (int i{}; i < n_large; ++i) {
+    Momentum momentum{PolarVector{rng.exp(1.), rng.uniform(0., M_PI),
+                                  rng.uniform(0., 2. * M_PI)}};
+    large_event.push(
+        Particle{PARTICLE_TYPE_TABLE[i % K_STAR].name, momentum});
+  }
+
+  PairArrays large_arrays{n_large, large_event.getPx(), large_event.getPy(),
+                          large_event.getPz(), large_event.getEnergy()};
+  std::vector<double> large_masses(n_large);
+
+  results.push_back(runBenchmark(
+      "pair loop (4000 particles)", 5,
+      [&](long long) {
+        double sum{};
+
+        for (int i{1}; i < n_large; ++i) {
+          computeInvariantMasses(large_event, i, large_masses.data());
+
+          for (int j{}; j < i; ++j) {
+            sum += large_masses[j];
+          }
+        }
+
+        g_sink = sum;
+      },
+      "pairs", n_large_pairs));
+
+  PairEngine pair_engine{};
+
+  results.push_back(runBenchmark(
+      "PairEngine (4000 particles)", 5,
+      [&](long long) {
+        double sum{};
+
+        pair_engine.run(large_arrays,
+                        [&](int, int, int n, double const* masses) {
+                          for (int k{}; k < n; ++k) {
+                            sum += masses[k];
+                          }
+                        });
+
+        g_sink = sum;
+      },
+      "pairs", n_large_pairs));
+
+  struct PairSum {
+    double sum;
+
+    void operator()(int, int, int n, double const* masses) {
+      for (int k{}; k < n; ++k) {
+        sum += masses[k];
+      }
+    }
+  };
+
+  int n_cores = std::max(1u, std::thread::hardware_concurrency());
+
+  results.push_back(runBenchmark(
+      "PairEngine parallel (4000 particles)", 5,
+      [&](long long) {
+        std::vector<PairSum> sums(n_cores, PairSum{0.});
+
+        pair_engine.runParallel(large_arrays, sums);
+
+        g_sink = sums[0].sum;
+      },
+      "pairs", n_large_pairs));
+
+  // full events, including histogram filling
+  auto histograms = createHistograms();
+  DecayEngine decays{};
+
+  // the events are generated by a single call, as in a run, so that the
+  // buffers allocated once per call are not counted in the time per event
+  int const n_events{2000};
+
+  generateEvents(0, n_events / 10, rng, species, decays, {}, histograms, 0,
+                 nullptr, nullptr, nullptr);
+
+  auto start = std::chrono::steady_clock::now();
+
+  generateEvents(0, n_events, rng, species, decays, {}, histograms, 0, nullptr,
+                 nullptr, nullptr);
+
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  double ns_per_event = elapsed.count() / n_events;
+
+  results.push_back({"event (100 particles)", n_events, ns_per_event, "events",
+                     1e9 / ns_per_event});
+
+  histograms.histo_list->Delete();
+  delete histograms.histo_list;
+
+  if (json) {
+    printJson(results);
+  } else {
+    printTable(results);
+  }
+}
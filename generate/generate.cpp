@@ -1,259 +1,752 @@
+#include "generate.hpp"
+
+#include <cmath>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "Checkpoint.hpp"
+#include "DecayEngine.hpp"
+#include "EventArena.hpp"
+#include "EventBuffer.hpp"
+#include "EventMixer.hpp"
+#include "EventWriter.hpp"
+#include "Instrumentation.hpp"
+#include "Kinematics.hpp"
+#include "PairEngine.hpp"
 #include "Particle.hpp"
 #include "ParticleType.hpp"
+#include "ParticleTypeTable.hpp"
+#include "RandomEngine.hpp"
 #include "ResonanceType.hpp"
+#include "SpeciesSampler.hpp"
 #include "TBenchmark.h"
 #include "TFile.h"
 #include "TH1.h"
 #include "TList.h"
 #include "TMath.h"
-#include "TRandom.h"
+#include "TROOT.h"
+
+GenerationHistograms createHistograms(bool mixed_histograms) {
+  GenerationHistograms histograms{};
+  histograms.histo_list = new TList();
+
+  // particle histograms
+  histograms.particle_types_h =
+      new TH1I("particle_types_h", "Particle types", 7, 0, 7);
+  histograms.histo_list->Add(histograms.particle_types_h);  // 0
+
+  histograms.azimutal_angles_h =
+      new TH1F("azimutal_angles_h", "Azimutal angles", 1e3, 0, TMath::Pi());
+  histograms.histo_list->Add(histograms.azimutal_angles_h);  // 1
+
+  histograms.polar_angles_h =
+      new TH1F("polar_angles_h", "Polar angles", 1e3, 0, TMath::Pi() * 2.);
+  histograms.histo_list->Add(histograms.polar_angles_h);  // 2
+
+  histograms.momentum_h = new TH1F("momentum_h", "Momentum", 1e3, 0, 9);
+  histograms.histo_list->Add(histograms.momentum_h);  // 3
+
+  histograms.momentum_xy_h =
+      new TH1F("momentum_xy_h", "Momentum xy", 1e3, 0, 9);
+  histograms.histo_list->Add(histograms.momentum_xy_h);  // 4
+
+  histograms.energy_h = new TH1F("energy_h", "Energy", 1e4, 0, 4);
+  histograms.histo_list->Add(histograms.energy_h);  // 5
+
+  // invariant mass histograms
+  histograms.invm_all_h =
+      new TH1F("invm_all_h", "Invariant mass, all particles",
+               InvariantMassAxis::n_bins, InvariantMassAxis::low,
+               InvariantMassAxis::high);
+  histograms.invm_all_h->Sumw2();
+  histograms.histo_list->Add(histograms.invm_all_h);  // 6
+
+  histograms.invm_opposite_charge_h =
+      new TH1F("invm_opposite_charge_h", "Invariant mass, opposite charge",
+               InvariantMassAxis::n_bins, InvariantMassAxis::low,
+               InvariantMassAxis::high);
+  histograms.invm_opposite_charge_h->Sumw2();
+  histograms.histo_list->Add(histograms.invm_opposite_charge_h);  // 7
+
+  histograms.invm_same_charge_h =
+      new TH1F("invm_same_charge_h", "Invariant mass, same charge",
+               InvariantMassAxis::n_bins, InvariantMassAxis::low,
+               InvariantMassAxis::high);
+  histograms.invm_same_charge_h->Sumw2();
+  histograms.histo_list->Add(histograms.invm_same_charge_h);  // 8
+
+  histograms.invm_pion_kaon_opposite_h =
+      new TH1F("invm_pion_kaon_opposite_h",
+               "Invariant mass, pion+ and kaon- or pion- and kaon+",
+               InvariantMassAxis::n_bins, InvariantMassAxis::low,
+               InvariantMassAxis::high);
+  histograms.invm_pion_kaon_opposite_h->Sumw2();
+  histograms.histo_list->Add(histograms.invm_pion_kaon_opposite_h);  // 9
+
+  histograms.invm_pion_kaon_same_h =
+      new TH1F("invm_pion_kaon_same_h",
+               "Invariant mass, pion+ and kaon+ or pion- and kaon-",
+               InvariantMassAxis::n_bins, InvariantMassAxis::low,
+               InvariantMassAxis::high);
+  histograms.invm_pion_kaon_same_h->Sumw2();
+  histograms.histo_list->Add(histograms.invm_pion_kaon_same_h);  // 10
+
+  histograms.invm_decayed_h =
+      new TH1F("invm_decayed_h", "Invariant mass, decayed particles from K*",
+               1e3, 0.6, 1.2);
+  histograms.invm_decayed_h->Sumw2();
+  histograms.histo_list->Add(histograms.invm_decayed_h);  // 11
+
+  if (!mixed_histograms) {
+    return histograms;
+  }
+
+  // mixed-event background histograms
+  histograms.invm_mixed_opposite_charge_h =
+      new TH1F("invm_mixed_opposite_charge_h",
+               "Invariant mass, opposite charge, mixed events",
+               InvariantMassAxis::n_bins, InvariantMassAxis::low,
+               InvariantMassAxis::high);
+  histograms.invm_mixed_opposite_charge_h->Sumw2();
+  histograms.histo_list->Add(histograms.invm_mixed_opposite_charge_h);  // 12
+
+  histograms.invm_mixed_pion_kaon_opposite_h =
+      new TH1F("invm_mixed_pion_kaon_opposite_h",
+               "Invariant mass, pion+ and kaon- or pion- and kaon+, mixed "
+               "events",
+               InvariantMassAxis::n_bins, InvariantMassAxis::low,
+               InvariantMassAxis::high);
+  histograms.invm_mixed_pion_kaon_opposite_h->Sumw2();
+  histograms.histo_list->Add(
+      histograms.invm_mixed_pion_kaon_opposite_h);  // 13
+
+  return histograms;
+}
+
+/**
+ * Invariant masses of the pairs sorted into one histogram, stored in an array
+ * handed out by the event arena.
+ */
+struct MassBuffer {
+  double* data;
+  int size;
+
+  void push(double invariant_mass) { data[size++] = invariant_mass; }
+};
+
+/**
+ * Invariant masses of the pairs formed by one particle, sorted by the
+ * histograms they belong to, so that every histogram is filled in bulk.
+ */
+struct PairMasses {
+  MassBuffer all;
+  MassBuffer opposite_charge;
+  MassBuffer same_charge;
+  MassBuffer pion_kaon_opposite;
+  MassBuffer pion_kaon_same;
+};
+
+/**
+ * Helper function to allocate the pair mass buffers from the arena, with room
+ * for the pairs of one particle with up to n partners.
+ */
+PairMasses allocatePairMasses(EventArena& arena, int n) {
+  return {{arena.allocate<double>(n), 0},
+          {arena.allocate<double>(n), 0},
+          {arena.allocate<double>(n), 0},
+          {arena.allocate<double>(n), 0},
+          {arena.allocate<double>(n), 0}};
+}
 
 /**
- * Helper function to fill invariant mass histograms with data coming from two
- * particles.
+ * Final-state particles of an event, the ones that are not decayed, packed
+ * next to each other with the arrays needed to pair them. class_masks holds
+ * the ParticleClass flags of each particle. The arrays belong to the event
+ * arena.
  */
-void fillHistograms(Particle const& particle_1, Particle const& particle_2,
-                    TH1F* invm_all_h, TH1F* invm_opposite_charge_h,
-                    TH1F* invm_same_charge_h, TH1F* invm_pion_kaon_opposite_h,
-                    TH1F* invm_pion_kaon_same_h) {
-  auto invariant_mass = particle_1.getInvariantMass(particle_2);
+struct FinalState {
+  int size;
+  double* px;
+  double* py;
+  double* pz;
+  double* energy;
+  unsigned* class_masks;
+};
 
+/**
+ * Helper function to copy the final-state particles of the event, in the same
+ * order, to arrays allocated from the arena.
+ */
+FinalState selectFinalState(EventBuffer const& event, DecayEngine const& decays,
+                            EventArena& arena) {
+  FinalState final_state{0,
+                         arena.allocate<double>(event.size()),
+                         arena.allocate<double>(event.size()),
+                         arena.allocate<double>(event.size()),
+                         arena.allocate<double>(event.size()),
+                         arena.allocate<unsigned>(event.size())};
+
+  auto type_id = event.getTypeId();
+  auto charge = event.getCharge();
+  int n{};
+
+  for (int i{}; i < event.size(); ++i) {
+    if (decays.isUnstable(type_id[i])) {
+      continue;
+    }
+
+    final_state.px[n] = event.getPx()[i];
+    final_state.py[n] = event.getPy()[i];
+    final_state.pz[n] = event.getPz()[i];
+    final_state.energy[n] = event.getEnergy()[i];
+    final_state.class_masks[n] = getParticleClass(type_id[i], charge[i]);
+    ++n;
+  }
+
+  final_state.size = n;
+
+  return final_state;
+}
+
+/**
+ * Helper function to sort the invariant mass of a pair into the buffers of the
+ * histograms it has to be filled in, given the PairClass flags of the pair.
+ */
+void addPair(unsigned pair_class, double invariant_mass,
+             PairMasses& pair_masses) {
   // invariant mass with all particles
-  invm_all_h->Fill(invariant_mass);
+  pair_masses.all.push(invariant_mass);
 
   // invariant mass with opposite charge particles
-  if (particle_2.getCharge() * particle_1.getCharge() < 0) {
-    invm_opposite_charge_h->Fill(invariant_mass);
+  if (pair_class & OPPOSITE_CHARGE) {
+    pair_masses.opposite_charge.push(invariant_mass);
   }
 
   // invariant mass with same charge particles
-  if (particle_2.getCharge() * particle_1.getCharge() > 0) {
-    invm_same_charge_h->Fill(invariant_mass);
+  if (pair_class & SAME_CHARGE) {
+    pair_masses.same_charge.push(invariant_mass);
   }
 
   // invariant mass with pion+ and kaon- or pion- and kaon+
-  if ((particle_1.getName() == "pion+" && particle_2.getName() == "kaon-") ||
-      (particle_1.getName() == "kaon-" && particle_2.getName() == "pion+") ||
-      (particle_1.getName() == "pion-" && particle_2.getName() == "kaon+") ||
-      (particle_1.getName() == "kaon+" && particle_2.getName() == "pion-")) {
-    invm_pion_kaon_opposite_h->Fill(invariant_mass);
+  if (pair_class & PION_KAON_OPPOSITE) {
+    pair_masses.pion_kaon_opposite.push(invariant_mass);
   }
 
-  // invariant mass with pion+ and kaon+ or piaon- and kaon-
-  if ((particle_1.getName() == "pion+" && particle_2.getName() == "kaon+") ||
-      (particle_1.getName() == "kaon+" && particle_2.getName() == "pion+") ||
-      (particle_1.getName() == "pion-" && particle_2.getName() == "kaon-") ||
-      (particle_1.getName() == "kaon-" && particle_2.getName() == "pion-")) {
-    invm_pion_kaon_same_h->Fill(invariant_mass);
+  // invariant mass with pion+ and kaon+ or pion- and kaon-
+  if (pair_class & PION_KAON_SAME) {
+    pair_masses.pion_kaon_same.push(invariant_mass);
   }
 }
 
-void generate(int n_gen, const char* file_name) {
+/**
+ * Helper function to fill the invariant mass histograms with the sorted pair
+ * masses. The buffers are emptied.
+ */
+void fillHistograms(PairMasses& pair_masses, GenerationHistograms& histograms) {
+  histograms.invm_all.fillN(pair_masses.all.data, pair_masses.all.size);
+  histograms.invm_opposite_charge.fillN(pair_masses.opposite_charge.data,
+                                        pair_masses.opposite_charge.size);
+  histograms.invm_same_charge.fillN(pair_masses.same_charge.data,
+                                    pair_masses.same_charge.size);
+  histograms.invm_pion_kaon_opposite.fillN(pair_masses.pion_kaon_opposite.data,
+                                           pair_masses.pion_kaon_opposite.size);
+  histograms.invm_pion_kaon_same.fillN(pair_masses.pion_kaon_same.data,
+                                       pair_masses.pion_kaon_same.size);
+
+  pair_masses.all.size = 0;
+  pair_masses.opposite_charge.size = 0;
+  pair_masses.same_charge.size = 0;
+  pair_masses.pion_kaon_opposite.size = 0;
+  pair_masses.pion_kaon_same.size = 0;
+}
+
+/**
+ * Helper function to fill the histogram of the invariant mass of the products
+ * of each decay. The products of a decay are stored next to each other, from
+ * the first_product-th particle of the event on.
+ */
+void fillDecayedMasses(EventBuffer const& event, int first_product,
+                       TH1F* histogram) {
+  auto px = event.getPx();
+  auto py = event.getPy();
+  auto pz = event.getPz();
+  auto energy = event.getEnergy();
+  auto parent = event.getParent();
+
+  int i{first_product};
+
+  while (i < event.size()) {
+    Momentum momentum{px[i], py[i], pz[i]};
+    double total_energy = energy[i];
+    int j{i + 1};
+
+    for (; j < event.size() && parent[j] == parent[i]; ++j) {
+      momentum = momentum + Momentum{px[j], py[j], pz[j]};
+      total_energy += energy[j];
+    }
+
+    histogram->Fill(
+        std::sqrt(std::pow(total_energy, 2) - momentum * momentum));
+
+    i = j;
+  }
+}
+
+void copyAccumulators(GenerationHistograms const& histograms) {
+  histograms.invm_all.copyTo(histograms.invm_all_h);
+  histograms.invm_opposite_charge.copyTo(histograms.invm_opposite_charge_h);
+  histograms.invm_same_charge.copyTo(histograms.invm_same_charge_h);
+  histograms.invm_pion_kaon_opposite.copyTo(
+      histograms.invm_pion_kaon_opposite_h);
+  histograms.invm_pion_kaon_same.copyTo(histograms.invm_pion_kaon_same_h);
+
+  if (histograms.invm_mixed_opposite_charge_h != nullptr) {
+    histograms.invm_mixed_opposite_charge.copyTo(
+        histograms.invm_mixed_opposite_charge_h);
+    histograms.invm_mixed_pion_kaon_opposite.copyTo(
+        histograms.invm_mixed_pion_kaon_opposite_h);
+  }
+}
+
+void generateEvents(int first_event, int n_events, RandomEngine& rng,
+                    SpeciesSampler const& species, DecayEngine const& decays,
+                    GenerationOptions const& options,
+                    GenerationHistograms& histograms, int thread,
+                    EventWriter* writer, EventMixer* mixer,
+                    CheckpointWriter* checkpoints) {
+  int const multiplicity = options.multiplicity;
+
+  // the buffer is allocated once and reused by every event. It grows if the
+  // decay products do not fit
+  EventBuffer event_particles{3 * multiplicity};
+
+  // the pairs are visited in tiles, which only matters for events much larger
+  // than the default one
+  PairEngine pair_engine{};
+
+  // scratch arrays of the event, released all together at the end of it
+  EventArena arena{};
+
+  // species and spherical momenta of the primaries, drawn in one batch at the
+  // start of every event
+  std::vector<int> primary_types(multiplicity);
+  std::vector<double> primary_p(multiplicity);
+  std::vector<double> primary_theta(multiplicity);
+  std::vector<double> primary_phi(multiplicity);
+
+  // angles of the primaries computed back from their momentum, unless the
+  // sampled ones are used
+  std::vector<double> polar_p(multiplicity);
+  std::vector<double> polar_theta(multiplicity);
+  std::vector<double> polar_phi(multiplicity);
+  double const* theta = primary_theta.data();
+  double const* phi = primary_phi.data();
+
+  if (!options.sampled_angles) {
+    theta = polar_theta.data();
+    phi = polar_phi.data();
+  }
+
+  for (int i{first_event}; i < n_events; ++i) {
+    INSTRUMENT_BEGIN(STAGE_TYPE);
+    species.sampleN(rng, primary_types.data(), multiplicity);
+    INSTRUMENT_END(STAGE_TYPE);
+
+    INSTRUMENT_BEGIN(STAGE_KINEMATICS);
+    sampleMomenta(rng, multiplicity, primary_p.data(), primary_theta.data(),
+                  primary_phi.data());
+    event_particles.setPrimaries(multiplicity, primary_types.data(),
+                                 primary_p.data(), primary_theta.data(),
+                                 primary_phi.data());
+    INSTRUMENT_END(STAGE_KINEMATICS);
+
+    if (!options.sampled_angles) {
+      INSTRUMENT_BEGIN(STAGE_PARTICLE_HISTOGRAMS);
+      cartesianToSpherical(event_particles.getPx(), event_particles.getPy(),
+                           event_particles.getPz(), multiplicity,
+                           polar_p.data(), polar_theta.data(),
+                           polar_phi.data());
+      INSTRUMENT_END(STAGE_PARTICLE_HISTOGRAMS);
+    }
+
+    // decay the resonances, appending their products after the primaries
+    INSTRUMENT_BEGIN(STAGE_DECAY);
+
+    int n_failed_decays = decays.decay(event_particles, rng);
+    INSTRUMENT_FAILED_DECAYS(n_failed_decays);
+
+    fillDecayedMasses(event_particles, multiplicity,
+                      histograms.invm_decayed_h);
+
+    INSTRUMENT_END(STAGE_DECAY);
+
+    auto type_ids = event_particles.getTypeId();
+
+    for (int j{}; j < multiplicity; ++j) {
+      // fill generation histograms
+      INSTRUMENT_BEGIN(STAGE_PARTICLE_HISTOGRAMS);
+
+      // type
+      histograms.particle_types_h->Fill(type_ids[j]);
+
+      Momentum momentum{event_particles.getPx()[j], event_particles.getPy()[j],
+                        event_particles.getPz()[j]};
+
+      // azimutal angle
+      histograms.azimutal_angles_h->Fill(theta[j]);
+
+      // polar angle
+      histograms.polar_angles_h->Fill(phi[j]);
+
+      // momentum
+      histograms.momentum_h->Fill(std::sqrt(momentum * momentum));
+
+      // momentum on xy plane
+      histograms.momentum_xy_h->Fill(
+          std::sqrt(momentum.x * momentum.x + momentum.y * momentum.y));
+
+      // energy
+      histograms.energy_h->Fill(event_particles.getEnergy()[j]);
+
+      INSTRUMENT_END(STAGE_PARTICLE_HISTOGRAMS);
+    }
+
+    // fill invariant mass histograms with every pair of final-state particles
+    INSTRUMENT_BEGIN(STAGE_PAIR_LOOP);
+
+    auto final_state = selectFinalState(event_particles, decays, arena);
+    auto pair_masses = allocatePairMasses(arena, final_state.size);
+
+    PairArrays pair_arrays{final_state.size, final_state.px, final_state.py,
+                           final_state.pz, final_state.energy};
+
+    pair_engine.run(pair_arrays, [&](int i, int j_begin, int n,
+                                     double const* masses) {
+      unsigned class_mask = final_state.class_masks[i];
+
+      for (int k{}; k < n; ++k) {
+        addPair(getPairClass(class_mask, final_state.class_masks[j_begin + k]),
+                masses[k], pair_masses);
+      }
+
+      fillHistograms(pair_masses, histograms);
+    });
+
+    INSTRUMENT_END(STAGE_PAIR_LOOP);
+
+    if (writer != nullptr) {
+      writer->write(thread, i, event_particles);
+    }
+
+    if (mixer != nullptr) {
+      mixer->mix(pair_arrays, final_state.class_masks);
+    }
+
+    arena.reset();
+
+    // the checkpoint is taken between two events, once the mixer has caught
+    // up, so that it holds the whole state of the thread
+    if (checkpoints != nullptr && (i + 1) % options.checkpoint_interval == 0) {
+      if (mixer != nullptr) {
+        mixer->drain();
+      }
+
+      checkpoints->save(thread, i + 1, rng, histograms, mixer);
+    }
+  }
+
+  INSTRUMENT_MERGE_THREAD();
+}
+
+bool generate(int n_gen, const char* file_name, int n_threads,
+              unsigned int seed, const char* events_file_name,
+              GenerationOptions const& options) {
   gBenchmark->Start("Benchmark");
 
+  // the compiled classes only have to be loaded when running as a ROOT macro,
+  // the standalone generator links them directly
+#ifdef __CLING__
   R__LOAD_LIBRARY(ParticleType_cpp.so)
   R__LOAD_LIBRARY(ResonanceType_cpp.so)
   R__LOAD_LIBRARY(Particle_cpp.so)
+  R__LOAD_LIBRARY(EventBuffer_cpp.so)
+  R__LOAD_LIBRARY(DecayEngine_cpp.so)
+  R__LOAD_LIBRARY(InvariantMass_cpp.so)
+  R__LOAD_LIBRARY(Kinematics_cpp.so)
+  R__LOAD_LIBRARY(EventWriter_cpp.so)
+  R__LOAD_LIBRARY(EventMixer_cpp.so)
+  R__LOAD_LIBRARY(Checkpoint_cpp.so)
+  R__LOAD_LIBRARY(SpeciesSampler_cpp.so)
+#endif
+
+  // the generator refers to particle types by their integer id, so the
+  // built-in types must occupy the first indices of the type table
+  if (!registerParticleTypes()) {
+    std::cout << "ERROR: The particle types table does not match the built-in "
+                 "particle type ids!"
+              << '\n';
+
+    return false;
+  }
 
-  // mass and width measured in GeV/c^2
-  Particle::addParticleType("pion+", 0.13957, 1);
-  Particle::addParticleType("pion-", 0.13957, -1);
-  Particle::addParticleType("kaon+", 0.49367, 1);
-  Particle::addParticleType("kaon-", 0.49367, -1);
-  Particle::addParticleType("proton+", 0.93827, 1);
-  Particle::addParticleType("proton-", 0.93827, -1);
-  Particle::addParticleType("k*", 0.89166, 0, 0.050);
+  if (n_threads < 1) {
+    std::cout << "ERROR: The number of threads must be positive!" << '\n';
 
-  gRandom->SetSeed();
+    return false;
+  }
 
-  TList* histo_list = new TList();
+  if (options.n_shards < 1 || options.shard < 0 ||
+      options.shard >= options.n_shards) {
+    std::cout << "ERROR: The shard must be between 0 and the number of shards "
+                 "minus one!"
+              << '\n';
 
-  // particle histograms
-  TH1I* particle_types_h =
-      new TH1I("particle_types_h", "Particle types", 7, 0, 7);
-  histo_list->Add(particle_types_h);  // 0
+    return false;
+  }
 
-  TH1F* azimutal_angles_h =
-      new TH1F("azimutal_angles_h", "Azimutal angles", 1e3, 0, TMath::Pi());
-  histo_list->Add(azimutal_angles_h);  // 1
+  // the shards only draw from disjoint substreams if they share the seed
+  if (options.n_shards > 1 && seed == 0) {
+    std::cout << "ERROR: The shards of a run need an explicit seed!" << '\n';
 
-  TH1F* polar_angles_h =
-      new TH1F("polar_angles_h", "Polar angles", 1e3, 0, TMath::Pi() * 2.);
-  histo_list->Add(polar_angles_h);  // 2
+    return false;
+  }
 
-  TH1F* momentum_h = new TH1F("momentum_h", "Momentum", 1e3, 0, 9);
-  histo_list->Add(momentum_h);  // 3
+  if (options.multiplicity < 0 || options.mixing_depth < 0 ||
+      options.checkpoint_interval < 0) {
+    std::cout << "ERROR: The multiplicity, the mixing depth and the checkpoint "
+                 "interval must not be negative!"
+              << '\n';
 
-  TH1F* momentum_xy_h = new TH1F("momentum_xy_h", "Momentum xy", 1e3, 0, 9);
-  histo_list->Add(momentum_xy_h);  // 4
+    return false;
+  }
 
-  TH1F* energy_h = new TH1F("energy_h", "Energy", 1e4, 0, 4);
-  histo_list->Add(energy_h);  // 5
+  for (auto const& abundance : options.abundances) {
+    if (Particle::getParticleType(abundance.type_id) == nullptr) {
+      std::cout << "ERROR: There is no particle type with id "
+                << abundance.type_id << "!" << '\n';
 
-  // invariant mass histograms
-  TH1F* invm_all_h =
-      new TH1F("invm_all_h", "Invariant mass, all particles", 1e4, 0, 9);
-  invm_all_h->Sumw2();
-  histo_list->Add(invm_all_h);  // 6
-
-  TH1F* invm_opposite_charge_h = new TH1F(
-      "invm_opposite_charge_h", "Invariant mass, opposite charge", 1e4, 0, 9);
-  invm_opposite_charge_h->Sumw2();
-  histo_list->Add(invm_opposite_charge_h);  // 7
-
-  TH1F* invm_same_charge_h =
-      new TH1F("invm_same_charge_h", "Invariant mass, same charge", 1e4, 0, 9);
-  invm_same_charge_h->Sumw2();
-  histo_list->Add(invm_same_charge_h);  // 8
-
-  TH1F* invm_pion_kaon_opposite_h =
-      new TH1F("invm_pion_kaon_opposite_h",
-               "Invariant mass, pion+ and kaon- or pion- and kaon+", 1e4, 0, 9);
-  invm_pion_kaon_opposite_h->Sumw2();
-  histo_list->Add(invm_pion_kaon_opposite_h);  // 9
+      return false;
+    }
+  }
 
-  TH1F* invm_pion_kaon_same_h =
-      new TH1F("invm_pion_kaon_same_h",
-               "Invariant mass, pion+ and kaon+ or pion- and kaon-", 1e4, 0, 9);
-  invm_pion_kaon_same_h->Sumw2();
-  histo_list->Add(invm_pion_kaon_same_h);  // 10
+  // the sampler is empty, after printing the reason, if the abundances are
+  // not valid
+  SpeciesSampler species{options.abundances};
 
-  TH1F* invm_decayed_h =
-      new TH1F("invm_decayed_h", "Invariant mass, decayed particles from K*",
-               1e3, 0.6, 1.2);
-  invm_decayed_h->Sumw2();
-  histo_list->Add(invm_decayed_h);  // 11
-
-  for (int i{}; i < n_gen; ++i) {
-    std::vector<Particle> event_particles(100);
-
-    event_particles.reserve(150);
-
-    for (int j{}; j < 100; ++j) {
-      auto r = gRandom->Exp(1);  // GeV
-      auto theta = gRandom->Uniform(0, TMath::Pi());
-      auto phi = gRandom->Uniform(0, TMath::Pi() * 2.);
-
-      // convert polar to cartesian coordinates
-      event_particles[j].setMomentum(Momentum{PolarVector{r, theta, phi}});
-
-      auto x = gRandom->Uniform(0, 1);
-
-      if (x <= 0.4) {
-        event_particles[j].setIndex("pion+");
-      } else if (x <= 0.8) {
-        event_particles[j].setIndex("pion-");
-      } else if (x <= 0.85) {
-        event_particles[j].setIndex("kaon+");
-      } else if (x <= 0.9) {
-        event_particles[j].setIndex("kaon-");
-      } else if (x <= 0.945) {
-        event_particles[j].setIndex("proton+");
-      } else if (x <= 0.99) {
-        event_particles[j].setIndex("proton-");
-      } else {
-        event_particles[j].setIndex("k*");
-
-        auto decay_into = gRandom->Uniform(0, 1);
-
-        Particle decay_product_1{};
-        Particle decay_product_2{};
-
-        if (decay_into <= 0.5) {
-          decay_product_1.setIndex("pion+");
-          decay_product_2.setIndex("kaon-");
-        } else {
-          decay_product_1.setIndex("pion-");
-          decay_product_2.setIndex("kaon+");
-        }
+  if (species.size() == 0) {
+    return false;
+  }
 
-        event_particles[j].decayToBody(decay_product_1, decay_product_2);
+  // the events already written to the events file are lost with the run, so
+  // they could not be completed
+  if (options.resume && (seed == 0 || events_file_name != nullptr)) {
+    std::cout << "ERROR: Resuming needs the seed of the interrupted run and "
+                 "cannot write an events file!"
+              << '\n';
 
-        // fill decay products invariant mass histogram
-        auto invariant_mass_products =
-            decay_product_1.getInvariantMass(decay_product_2);
+    return false;
+  }
 
-        invm_decayed_h->Fill(invariant_mass_products);
+  if (seed == 0) {
+    seed = std::random_device{}() | 1u;
+  }
 
-        event_particles.push_back(decay_product_1);
-        event_particles.push_back(decay_product_2);
-      }
+  std::cout << "Seed: " << seed << ", threads: " << n_threads;
 
-      // fill generation histograms
-      auto const& new_particle = event_particles[j];
+  if (options.n_shards > 1) {
+    std::cout << ", shard: " << options.shard << " of " << options.n_shards;
+  }
 
-      // type
-      particle_types_h->Fill(new_particle.getIndex().value());
+  std::cout << '\n';
 
-      auto momentum = new_particle.getMomentum();
-      auto polar_momentum = momentum.getPolar();
+  // particle errors are only counted during the generation and reported once
+  // at the end
+  Particle::resetErrors();
 
-      // azimutal angle
-      azimutal_angles_h->Fill(polar_momentum.theta);
+  if (n_threads > 1 || events_file_name != nullptr) {
+    ROOT::EnableThreadSafety();
+  }
 
-      // polar angle
-      polar_angles_h->Fill(polar_momentum.phi);
+  std::unique_ptr<EventWriter> writer{};
 
-      // momentum
-      momentum_h->Fill(std::sqrt(momentum * momentum));
+  if (events_file_name != nullptr) {
+    writer.reset(new EventWriter{events_file_name});
 
-      // momentum on xy plane
-      momentum_xy_h->Fill(
-          std::sqrt(momentum.x * momentum.x + momentum.y * momentum.y));
+    if (!writer->isOpen()) {
+      return false;
+    }
+  }
 
-      // energy
-      energy_h->Fill(new_particle.getEnergy());
-
-      // fill invariant mass histograms. This loop improves performance because
-      // it avoids unnecessary iterations in the loop after completing the event
-      // generation
-      if (new_particle.getName() != "k*") {
-        for (auto invm_i = j - 1; invm_i >= 0; --invm_i) {
-          auto const& invm_particle = event_particles[invm_i];
-
-          if (invm_particle.getName() == "k*") {
-            continue;
-          }
-
-          fillHistograms(new_particle, invm_particle, invm_all_h,
-                         invm_opposite_charge_h, invm_same_charge_h,
-                         invm_pion_kaon_opposite_h, invm_pion_kaon_same_h);
+  // histograms are owned by the generator and written explicitly, keep them
+  // out of the current ROOT directory so that the copies do not clash
+  auto add_directory = TH1::AddDirectoryStatus();
+  TH1::AddDirectory(kFALSE);
+
+  std::vector<GenerationHistograms> thread_histograms{};
+  std::vector<RandomEngine> thread_rngs{};
+
+  // every thread draws from its own substream of the seed, obtained by jumping
+  // the engine ahead once per thread index. The streams never overlap and only
+  // depend on the seed and on the thread index. The threads of a shard have
+  // the indices they would have in the whole run, so they come after the
+  // threads of the previous shards
+  RandomEngine rng{seed};
+  DecayEngine decays{};
+  int const first_thread = options.shard * n_threads;
+  int const n_run_threads = options.n_shards * n_threads;
+
+  for (int t{}; t < first_thread; ++t) {
+    rng.jump();
+  }
+
+  for (int t{}; t < n_threads; ++t) {
+    thread_histograms.push_back(createHistograms(options.mixing_depth > 0));
+    thread_rngs.push_back(rng);
+    rng.jump();
+  }
+
+  TH1::AddDirectory(add_directory);
+
+  // every thread hands its events to its own mixer, so that the mixed
+  // histograms do not depend on how the threads are scheduled
+  std::vector<std::unique_ptr<EventMixer>> mixers{};
+
+  for (int t{}; t < n_threads; ++t) {
+    mixers.emplace_back(options.mixing_depth > 0
+                            ? new EventMixer{thread_histograms[t],
+                                             options.mixing_depth}
+                            : nullptr);
+  }
+
+  CheckpointHeader checkpoint_header{seed,
+                                     n_gen,
+                                     n_threads,
+                                     options.shard,
+                                     options.n_shards,
+                                     options.multiplicity,
+                                     options.mixing_depth,
+                                     options.sampled_angles,
+                                     hashAbundances(options.abundances)};
+  std::unique_ptr<CheckpointWriter> checkpoints{};
+
+  if (options.checkpoint_interval > 0) {
+    checkpoints.reset(new CheckpointWriter{file_name, checkpoint_header});
+  }
+
+  // a resumed thread continues from the event after its checkpoint, with the
+  // random number engine, histograms and mixer it had at that point. Threads
+  // without a checkpoint start over
+  std::vector<int> first_events(n_threads);
+
+  if (options.resume) {
+    for (int t{}; t < n_threads; ++t) {
+      first_events[t] =
+          loadCheckpoint(file_name, checkpoint_header, t, thread_rngs[t],
+                         thread_histograms[t], mixers[t].get());
+
+      if (first_events[t] < 0) {
+        std::cout << "ERROR: The checkpoint of thread " << t
+                  << " is broken or belongs to a different run!" << '\n';
+
+        for (auto& histograms : thread_histograms) {
+          histograms.histo_list->Delete();
+          delete histograms.histo_list;
         }
+
+        return false;
       }
+
+      std::cout << "Thread " << t << " resumes from event " << first_events[t]
+                << '\n';
     }
+  }
 
-    // fill invariant mass histograms with combinations including decayed
-    // particles
-    auto event_particles_begin = event_particles.begin();
-    auto event_particles_end = event_particles.end();
+  // events are split as evenly as possible among the threads of the whole run,
+  // the first threads take the remainder
+  std::vector<std::thread> threads{};
 
-    for (auto it = event_particles_begin + 100; it < event_particles_end;
-         ++it) {
-      auto const& decayed_particle = *it;
+  for (int t{}; t < n_threads; ++t) {
+    int run_thread = first_thread + t;
+    int n_events =
+        n_gen / n_run_threads + (run_thread < n_gen % n_run_threads ? 1 : 0);
 
-      for (auto invm_it = event_particles_begin; invm_it < it; ++invm_it) {
-        auto const& invm_particle = *invm_it;
+    threads.emplace_back(generateEvents, first_events[t], n_events,
+                         std::ref(thread_rngs[t]), std::cref(species),
+                         std::cref(decays), std::cref(options),
+                         std::ref(thread_histograms[t]), t, writer.get(),
+                         mixers[t].get(), checkpoints.get());
+  }
 
-        if (invm_particle.getName() == "k*") {
-          continue;
-        }
+  for (auto& thread : threads) {
+    thread.join();
+  }
 
-        fillHistograms(decayed_particle, invm_particle, invm_all_h,
-                       invm_opposite_charge_h, invm_same_charge_h,
-                       invm_pion_kaon_opposite_h, invm_pion_kaon_same_h);
-      }
+  for (auto& mixer : mixers) {
+    if (mixer) {
+      mixer->close();
     }
   }
 
+  if (checkpoints) {
+    checkpoints->close();
+  }
+
+  if (writer && !writer->close()) {
+    std::cout << "ERROR: Could not write all the events to " << events_file_name
+              << "!" << '\n';
+
+    return false;
+  }
+
+  for (auto const& histograms : thread_histograms) {
+    copyAccumulators(histograms);
+  }
+
+  // merge the histograms in thread order, so that the result is reproducible
+  auto histo_list = thread_histograms[0].histo_list;
+
+  for (int t{1}; t < n_threads; ++t) {
+    auto thread_list = thread_histograms[t].histo_list;
+
+    for (int h{}; h < histo_list->GetSize(); ++h) {
+      static_cast<TH1*>(histo_list->At(h))
+          ->Add(static_cast<TH1*>(thread_list->At(h)));
+    }
+
+    thread_list->Delete();
+    delete thread_list;
+  }
+
   TFile* file = new TFile(file_name, "RECREATE");
 
+  if (file->IsZombie()) {
+    std::cout << "ERROR: Could not write " << file_name << "!" << '\n';
+
+    delete file;
+    return false;
+  }
+
   histo_list->Write();
 
   file->Close();
 
+  // the output is complete, so the checkpoints are not needed any more
+  if (options.checkpoint_interval > 0 || options.resume) {
+    removeCheckpoints(file_name, n_threads);
+  }
+
   gBenchmark->Show("Benchmark");
-}
\ No newline at end of file
+
+  // the error counters are not checkpointed, so a resumed run only reports
+  // its own errors
+  Particle::printErrors();
+
+  INSTRUMENT_REPORT(std::cout);
+
+  return true;
+}
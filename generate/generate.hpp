@@ -0,0 +1,157 @@
+#ifndef GENERATE_HPP
+#define GENERATE_HPP
+
+#include <vector>
+
+#include "Histogram.hpp"
+#include "ParticleTypeTable.hpp"
+#include "SpeciesSampler.hpp"
+#include "TH1.h"
+#include "TList.h"
+
+class CheckpointWriter;
+class DecayEngine;
+class EventMixer;
+class EventWriter;
+class RandomEngine;
+
+// axis of the invariant mass histograms of the pairs, in GeV/c^2
+struct InvariantMassAxis {
+  static constexpr int n_bins = 10000;
+  static constexpr double low = 0.;
+  static constexpr double high = 9.;
+};
+
+using InvariantMassHistogram = Histogram<InvariantMassAxis>;
+
+/**
+ * Histograms filled during the generation. Every worker thread fills its own
+ * set, and the sets are merged before being written to file.
+ */
+struct GenerationHistograms {
+  TList* histo_list;
+
+  TH1I* particle_types_h;
+  TH1F* azimutal_angles_h;
+  TH1F* polar_angles_h;
+  TH1F* momentum_h;
+  TH1F* momentum_xy_h;
+  TH1F* energy_h;
+  TH1F* invm_all_h;
+  TH1F* invm_opposite_charge_h;
+  TH1F* invm_same_charge_h;
+  TH1F* invm_pion_kaon_opposite_h;
+  TH1F* invm_pion_kaon_same_h;
+  TH1F* invm_decayed_h;
+
+  // only created when the events are mixed, null otherwise
+  TH1F* invm_mixed_opposite_charge_h;
+  TH1F* invm_mixed_pion_kaon_opposite_h;
+
+  // the pair histograms are filled in these accumulators, which are copied to
+  // the TH1F objects above once the generation is over. The mixed ones are
+  // filled by the EventMixer of the thread
+  InvariantMassHistogram invm_all;
+  InvariantMassHistogram invm_opposite_charge;
+  InvariantMassHistogram invm_same_charge;
+  InvariantMassHistogram invm_pion_kaon_opposite;
+  InvariantMassHistogram invm_pion_kaon_same;
+  InvariantMassHistogram invm_mixed_opposite_charge;
+  InvariantMassHistogram invm_mixed_pion_kaon_opposite;
+};
+
+/**
+ * Helper function to create a new set of the generation histograms. They are
+ * stored in the histo_list in the order expected by the analysis. The
+ * mixed-event histograms are only created if mixed_histograms is true, after
+ * the original twelve, so that a run without mixing writes the same twelve
+ * histograms as before.
+ */
+GenerationHistograms createHistograms(bool mixed_histograms = false);
+
+/**
+ * Helper function to copy the pair accumulators to the histograms that are
+ * written to file.
+ */
+void copyAccumulators(GenerationHistograms const& histograms);
+
+/**
+ * Default abundances of the primary particles. Other collision systems can
+ * pass their own table to generate() through GenerationOptions.
+ */
+inline std::vector<SpeciesAbundance> const PRIMARY_ABUNDANCES{
+    {PION_PLUS, 0.4},     {PION_MINUS, 0.4},    {KAON_PLUS, 0.05},
+    {KAON_MINUS, 0.05},   {PROTON_PLUS, 0.045}, {PROTON_MINUS, 0.045},
+    {K_STAR, 0.01}};
+
+/**
+ * Options of the generation. The defaults give the standard configuration: 100
+ * primaries per event with the PRIMARY_ABUNDANCES and no event mixing.
+ */
+struct GenerationOptions {
+  // number of primary particles of every event
+  int multiplicity{100};
+
+  // number of previous events each event is mixed with to fill the mixed-event
+  // histograms, 0 to disable the mixing
+  int mixing_depth{0};
+
+  // fill the angle histograms with the sampled theta and phi of the primaries
+  // instead of computing them back from the momentum
+  bool sampled_angles{false};
+
+  // number of events every thread generates between two checkpoints of its
+  // state, 0 to disable the checkpoints
+  int checkpoint_interval{0};
+
+  // continue an interrupted run with the same arguments from its checkpoints
+  bool resume{false};
+
+  // a run can be split into n_shards independent processes, each generating
+  // the events of n_threads of the n_shards * n_threads threads of the whole
+  // run. Merging the outputs of the shards gives the histograms of the whole
+  // run
+  int shard{0};
+  int n_shards{1};
+
+  // abundances of the primary species, which do not need to be normalized
+  std::vector<SpeciesAbundance> abundances{PRIMARY_ABUNDANCES};
+};
+
+/**
+ * Generate the events from first_event to n_events - 1 of a thread, drawing
+ * random numbers from rng and filling the given set of histograms. This is the
+ * work done by each generation thread. The primary species are drawn from
+ * species and the resonances are decayed by decays. When writer is not null,
+ * every event is also streamed to the events tree, and when mixer is not null
+ * its final-state particles are also handed to the event mixer. When
+ * checkpoints is not null, the state of the thread is saved every
+ * options.checkpoint_interval events.
+ */
+void generateEvents(int first_event, int n_events, RandomEngine& rng,
+                    SpeciesSampler const& species, DecayEngine const& decays,
+                    GenerationOptions const& options,
+                    GenerationHistograms& histograms, int thread,
+                    EventWriter* writer, EventMixer* mixer,
+                    CheckpointWriter* checkpoints);
+
+/**
+ * Generate n_gen events and write the histograms to file_name. The events are
+ * split among n_threads worker threads, each with its own random number stream
+ * and its own set of histograms. When the run is split into shards, n_gen is
+ * the number of events of the whole run, and this process only generates its
+ * share of them. The output only depends on the seed and on the
+ * number of threads. A zero seed is replaced by a random one, which is printed
+ * so that the run can be reproduced. If events_file_name is given, the events
+ * are also streamed to a tree in that file while they are generated. options
+ * sets the multiplicity and the event mixing, which runs on one background
+ * thread per worker thread, and the checkpoints. A resumed run needs the seed
+ * of the interrupted one, and produces the same output as if it had never been
+ * interrupted. The checkpoints are deleted once the output is written.
+ * Returns false, after printing the reason, if the run fails.
+ */
+bool generate(int n_gen, const char* file_name, int n_threads = 1,
+              unsigned int seed = 0, const char* events_file_name = nullptr,
+              GenerationOptions const& options = {});
+
+#endif
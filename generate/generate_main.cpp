@@ -0,0 +1,139 @@
+#include <getopt.h>
+
+#include <iostream>
+#include <string>
+
+#include "ParseOption.hpp"
+#include "generate.hpp"
+
+void printUsage(const char* program) {
+  std::cout << "Usage: " << program << " [options]" << '\n'
+            << "  -n, --events N         number of events (default 100000)\n"
+            << "  -s, --seed SEED        random seed, 0 for a random one "
+               "(default 0)\n"
+            << "  -t, --threads N        number of worker threads (default "
+               "1)\n"
+            << "  -o, --output FILE      histograms output file (default "
+               "generated.root)\n"
+            << "  -e, --events-file FILE also stream the events to FILE\n"
+            << "  -m, --multiplicity N   primary particles per event (default "
+               "100)\n"
+            << "  -x, --mixing-depth N   mix every event with the N previous "
+               "ones (default 0)\n"
+            << "  -a, --sampled-angles   fill the angle histograms with the "
+               "sampled angles\n"
+            << "  -c, --checkpoint N     save the state of the threads every N "
+               "events\n"
+            << "  -r, --resume           continue an interrupted run from its "
+               "checkpoints\n"
+            << "  -k, --shards K         split the run into K shards (default "
+               "1)\n"
+            << "  -i, --shard I          generate the I-th shard, from 0 "
+               "(default 0)\n"
+            << "  -h, --help             print this message\n";
+}
+
+int main(int argc, char** argv) {
+  int n_gen{100000};
+  unsigned int seed{0};
+  int n_threads{1};
+  std::string file_name{"generated.root"};
+  std::string events_file_name{};
+  GenerationOptions generation_options{};
+
+  option const long_options[]{{"events", required_argument, nullptr, 'n'},
+                              {"seed", required_argument, nullptr, 's'},
+                              {"threads", required_argument, nullptr, 't'},
+                              {"output", required_argument, nullptr, 'o'},
+                              {"events-file", required_argument, nullptr, 'e'},
+                              {"multiplicity", required_argument, nullptr,
+                               'm'},
+                              {"mixing-depth", required_argument, nullptr,
+                               'x'},
+                              {"sampled-angles", no_argument, nullptr, 'a'},
+                              {"checkpoint", required_argument, nullptr, 'c'},
+                              {"resume", no_argument, nullptr, 'r'},
+                              {"shards", required_argument, nullptr, 'k'},
+                              {"shard", required_argument, nullptr, 'i'},
+                              {"help", no_argument, nullptr, 'h'},
+                              {nullptr, 0, nullptr, 0}};
+
+  int option{};
+  bool valid{true};
+
+  while ((option = getopt_long(argc, argv, "n:s:t:o:e:m:x:ac:rk:i:h",
+                               long_options, nullptr)) != -1) {
+    switch (option) {
+      case 'n':
+        valid = parseInt(optarg, n_gen);
+        break;
+      case 's':
+        valid = parseSeed(optarg, seed);
+        break;
+      case 't':
+        valid = parseInt(optarg, n_threads);
+        break;
+      case 'o':
+        file_name = optarg;
+        break;
+      case 'e':
+        events_file_name = optarg;
+        break;
+      case 'm':
+        valid = parseInt(optarg, generation_options.multiplicity);
+        break;
+      case 'x':
+        valid = parseInt(optarg, generation_options.mixing_depth);
+        break;
+      case 'a':
+        generation_options.sampled_angles = true;
+        break;
+      case 'c':
+        valid = parseInt(optarg, generation_options.checkpoint_interval);
+        break;
+      case 'r':
+        generation_options.resume = true;
+        break;
+      case 'k':
+        valid = parseInt(optarg, generation_options.n_shards);
+        break;
+      case 'i':
+        valid = parseInt(optarg, generation_options.shard);
+        break;
+      case 'h':
+        printUsage(argv[0]);
+        return 0;
+      default:
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (!valid) {
+      std::cout << "ERROR: Invalid value " << optarg << " for option -"
+                << static_cast<char>(option) << "!" << '\n';
+
+      return 1;
+    }
+  }
+
+  if (optind < argc) {
+    std::cout << "ERROR: Unexpected argument " << argv[optind] << "!" << '\n';
+
+    return 1;
+  }
+
+  if (n_gen < 0 || n_threads < 1) {
+    std::cout << "ERROR: The number of events must not be negative and the "
+                 "number of threads must be positive!"
+              << '\n';
+
+    return 1;
+  }
+
+  bool ok = generate(
+      n_gen, file_name.c_str(), n_threads, seed,
+      events_file_name.empty() ? nullptr : events_file_name.c_str(),
+      generation_options);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+#include "merge.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "TFile.h"
+#include "TH1.h"
+#include "TKey.h"
+#include "TList.h"
+#include "TROOT.h"
+
+/**
+ * Helper function to open a histogram file and read the names of the
+ * histograms it holds, in the order they were written. Returns nullptr if the
+ * file cannot be opened.
+ */
+std::unique_ptr<TFile> openHistogramFile(std::string const& file_name,
+                                         std::vector<std::string>& names) {
+  std::unique_ptr<TFile> file{TFile::Open(file_name.c_str(), "READ")};
+
+  if (!file || file->IsZombie()) {
+    return nullptr;
+  }
+
+  auto key_list = file->GetListOfKeys();
+
+  for (int i{}; i < key_list->GetSize(); ++i) {
+    names.push_back(static_cast<TKey*>(key_list->At(i))->GetName());
+  }
+
+  return file;
+}
+
+/**
+ * Helper function to add the histograms of the files from first to last - 1
+ * to sums, in the order of names. Empty entries of sums take the histograms of
+ * the first file read. Only one file is open at a time.
+ */
+bool addFiles(std::vector<std::string> const& file_names, int first, int last,
+              std::vector<std::string> const& names, std::vector<TH1*>& sums) {
+  for (int f{first}; f < last; ++f) {
+    std::vector<std::string> file_histogram_names{};
+    auto file = openHistogramFile(file_names[f], file_histogram_names);
+
+    if (!file || file_histogram_names != names) {
+      std::cout << "ERROR: " << file_names[f]
+                << " does not hold the same histograms as the first file!"
+                << '\n';
+
+      return false;
+    }
+
+    for (std::size_t h{}; h < names.size(); ++h) {
+      TH1* histogram{nullptr};
+      file->GetObject(names[h].c_str(), histogram);
+
+      if (histogram == nullptr) {
+        std::cout << "ERROR: Could not read " << names[h] << " from "
+                  << file_names[f] << "!" << '\n';
+
+        return false;
+      }
+
+      // the histograms are not attached to the file, so they are owned here
+      if (sums[h] == nullptr) {
+        sums[h] = histogram;
+      } else {
+        sums[h]->Add(histogram);
+        delete histogram;
+      }
+    }
+
+    file->Close();
+  }
+
+  return true;
+}
+
+bool merge(std::vector<std::string> const& input_file_names,
+           const char* file_name, int n_threads) {
+  std::vector<std::string> names{};
+
+  if (input_file_names.empty() || n_threads < 1) {
+    std::cout << "ERROR: There must be at least one file to merge and one "
+                 "thread!"
+              << '\n';
+
+    return false;
+  }
+
+  if (!openHistogramFile(input_file_names[0], names)) {
+    std::cout << "ERROR: Could not open " << input_file_names[0] << "!"
+              << '\n';
+
+    return false;
+  }
+
+  int n_files = input_file_names.size();
+  n_threads = std::min(n_threads, n_files);
+
+  if (n_threads > 1) {
+    ROOT::EnableThreadSafety();
+  }
+
+  // the histograms read from the files must not be attached to them, so that
+  // they survive the file being closed
+  auto add_directory = TH1::AddDirectoryStatus();
+  TH1::AddDirectory(kFALSE);
+
+  std::vector<std::vector<TH1*>> thread_sums(
+      n_threads, std::vector<TH1*>(names.size(), nullptr));
+  std::vector<char> thread_ok(n_threads);
+  std::vector<std::thread> threads{};
+
+  for (int t{}; t < n_threads; ++t) {
+    threads.emplace_back([&, t] {
+      thread_ok[t] = addFiles(input_file_names, n_files * t / n_threads,
+                              n_files * (t + 1) / n_threads, names,
+                              thread_sums[t]);
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  TH1::AddDirectory(add_directory);
+
+  bool ok = std::all_of(thread_ok.begin(), thread_ok.end(),
+                        [](char thread_ok) { return thread_ok != 0; });
+
+  if (ok) {
+    // the partial sums are added in thread order, so that the result is
+    // reproducible
+    auto& sums = thread_sums[0];
+
+    for (int t{1}; t < n_threads; ++t) {
+      for (std::size_t h{}; h < names.size(); ++h) {
+        sums[h]->Add(thread_sums[t][h]);
+      }
+    }
+
+    TFile* file = new TFile(file_name, "RECREATE");
+
+    if (file->IsZombie()) {
+      std::cout << "ERROR: Could not write " << file_name << "!" << '\n';
+
+      ok = false;
+    } else {
+      for (auto histogram : sums) {
+        histogram->Write();
+      }
+
+      file->Close();
+
+      std::cout << "Merged " << n_files << " files into " << file_name
+                << '\n';
+    }
+
+    delete file;
+  }
+
+  for (auto& sums : thread_sums) {
+    for (auto histogram : sums) {
+      delete histogram;
+    }
+  }
+
+  return ok;
+}
@@ -0,0 +1,22 @@
+#ifndef MERGE_HPP
+#define MERGE_HPP
+
+#include <string>
+#include <vector>
+
+/**
+ * Merge the histogram files written by the shards of a run into file_name, as
+ * if the run had not been split. Every input file must hold the same
+ * histograms, which are written in the order of the first file, the one
+ * expected by the analysis.
+ *
+ * The files are read one at a time by n_threads threads, each summing a
+ * contiguous block of them. The partial sums are then added in thread order,
+ * so the bin contents do not depend on n_threads and the statistics only
+ * through the rounding of their sums. Returns false if a file cannot be read
+ * or does not match the first one.
+ */
+bool merge(std::vector<std::string> const& input_file_names,
+           const char* file_name, int n_threads = 1);
+
+#endif
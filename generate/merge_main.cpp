@@ -0,0 +1,64 @@
+#include <getopt.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ParseOption.hpp"
+#include "merge.hpp"
+
+void printUsage(const char* program) {
+  std::cout << "Usage: " << program << " [options] FILE..." << '\n'
+            << "  -o, --output FILE      merged output file (default "
+               "merged.root)\n"
+            << "  -t, --threads N        number of reading threads (default "
+               "one per core)\n"
+            << "  -h, --help             print this message\n";
+}
+
+int main(int argc, char** argv) {
+  std::string file_name{"merged.root"};
+  int n_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  option const long_options[]{{"output", required_argument, nullptr, 'o'},
+                              {"threads", required_argument, nullptr, 't'},
+                              {"help", no_argument, nullptr, 'h'},
+                              {nullptr, 0, nullptr, 0}};
+
+  int option{};
+
+  while ((option = getopt_long(argc, argv, "o:t:h", long_options, nullptr)) !=
+         -1) {
+    switch (option) {
+      case 'o':
+        file_name = optarg;
+        break;
+      case 't':
+        if (!parseInt(optarg, n_threads) || n_threads < 1) {
+          std::cout << "ERROR: Invalid value " << optarg << " for option -t!"
+                    << '\n';
+
+          return 1;
+        }
+
+        break;
+      case 'h':
+        printUsage(argv[0]);
+        return 0;
+      default:
+        printUsage(argv[0]);
+        return 1;
+    }
+  }
+
+  std::vector<std::string> input_file_names(argv + optind, argv + argc);
+
+  if (input_file_names.empty()) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  return merge(input_file_names, file_name.c_str(), n_threads) ? 0 : 1;
+}
@@ -1,9 +1,25 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <thread>
 #include <vector>
 
+#include "Checkpoint.hpp"
+#include "DecayEngine.hpp"
+#include "EventArena.hpp"
+#include "EventBuffer.hpp"
+#include "EventMixer.hpp"
+#include "LorentzVector.hpp"
+#include "PairEngine.hpp"
 #include "Particle.hpp"
 #include "ParticleType.hpp"
+#include "RandomEngine.hpp"
 #include "ResonanceType.hpp"
+#include "SpeciesSampler.hpp"
+#include "TH1.h"
+#include "TList.h"
+#include "generate.hpp"
 
 int main() {
   std::cout << "TESTING THE \"ParticleType\" AND \"ResonanceType\" CLASSES"
@@ -29,6 +45,37 @@ int main() {
     p->print();
   }
 
+  // mean, standard deviation and minimum of the masses sampled from every line
+  // shape, truncated at a threshold of 0.8
+  RandomEngine mass_engine{3};
+
+  for (auto line_shape : {GAUSSIAN, BREIT_WIGNER, RELATIVISTIC_BREIT_WIGNER}) {
+    ResonanceType resonance{"line shape test", 0.89166, 0, 0.05, line_shape};
+    resonance.addDecayChannel({1., {0, 0}}, 0.8);
+
+    int const n_masses{100000};
+    double sum{};
+    double sum_squares{};
+    double min_mass{resonance.getMass()};
+
+    for (int i{}; i < n_masses; ++i) {
+      double mass = resonance.sampleMass(mass_engine.uniform());
+      sum += mass;
+      sum_squares += mass * mass;
+      min_mass = std::min(min_mass, mass);
+    }
+
+    double mean = sum / n_masses;
+
+    std::cout << line_shape << ' ' << mean << ' '
+              << std::sqrt(sum_squares / n_masses - mean * mean) << ' '
+              << (min_mass >= resonance.getThreshold()) << '\n';
+  }
+
+  ResonanceType closed{"closed test", 0.89166, 0, 0.05};
+  closed.addDecayChannel({1., {0, 0}}, 1.5);
+  std::cout << closed.sampleMass(0.5) << '\n';
+
   std::cout << "\n\n"
             << "TESTING THE \"Particle\" CLASS" << '\n';
 
@@ -48,8 +95,278 @@ int main() {
   n.setIndex("neutron");
   n.printData();
 
+  Particle invalid{"muon"};
+  std::cout << invalid.getMass() << ' ' << invalid.getCharge() << ' '
+            << invalid.getEnergy() << '\n';
+  std::cout << Particle::countErrors(Particle::INVALID_INDEX) << '\n';
+  Particle::printErrors();
+  Particle::resetErrors();
+
   std::cout << "\n\n"
             << "PRINTING PARTICLE TYPES" << '\n';
 
   Particle::printParticleTypes();
+
+  std::cout << "\n\n"
+            << "TESTING THE \"EventBuffer\" CLASS" << '\n';
+
+  EventBuffer buffer{1};
+  buffer.push(e);
+  buffer.push(Particle{"proton", {1., 2., 3.}});
+  buffer.push(n);
+
+  std::cout << buffer.size() << ' ' << buffer.capacity() << '\n';
+
+  for (int i{}; i < buffer.size(); ++i) {
+    std::cout << buffer.getPx()[i] << ' ' << buffer.getEnergy()[i] << ' '
+              << buffer.getCharge()[i] << ' ' << buffer.getTypeId()[i] << '\n';
+    buffer.getParticle(i).printData();
+  }
+
+  buffer.clear();
+  std::cout << buffer.size() << ' ' << buffer.capacity() << '\n';
+
+  std::cout << "\n\n"
+            << "TESTING THE \"SpeciesSampler\" CLASS" << '\n';
+
+  SpeciesSampler sampler{{{0, 0.5}, {4, 0.3}, {6, 0.2}}};
+  RandomEngine engine{1};
+  std::vector<int> types(100000);
+  int counts[7]{};
+
+  sampler.sampleN(engine, types.data(), types.size());
+
+  for (int type : types) {
+    ++counts[type];
+  }
+
+  std::cout << sampler.size() << ' ' << sampler.sample(engine) << '\n';
+
+  for (int i{}; i < 7; ++i) {
+    std::cout << i << ' ' << counts[i] / 100000. << '\n';
+  }
+
+  SpeciesSampler empty_sampler{{}};
+  SpeciesSampler zero_sampler{{{0, 0.}, {4, 0.}}};
+  SpeciesSampler negative_sampler{{{0, 0.5}, {4, -0.1}}};
+
+  std::cout << empty_sampler.size() << ' ' << zero_sampler.size() << ' '
+            << negative_sampler.size() << ' '
+            << negative_sampler.sample(engine) << '\n';
+
+  std::cout << "\n\n"
+            << "TESTING THE \"LorentzVector\" STRUCT" << '\n';
+
+  LorentzVector vectors[2]{LorentzVector::fromMass(0., 0., 0., 0.89166),
+                           LorentzVector::fromMass(1., 2., 3., 0.13957)};
+
+  boostVectors(vectors, 2, 0.6, 0., 0.);
+
+  for (auto const& vector : vectors) {
+    std::cout << vector.px << ' ' << vector.py << ' ' << vector.pz << ' '
+              << vector.energy << ' ' << vector.getMass() << '\n';
+  }
+
+  std::cout << "\n\n"
+            << "TESTING THE \"DecayEngine\" CLASS" << '\n';
+
+  Particle::addParticleType("pi", 0.13957, 0);
+  Particle::addParticleType("omega", 0.78266, 0, 0.00868);
+  Particle::addDecayChannel("omega", 0.9, {"pi", "pi", "pi"});
+  Particle::addDecayChannel("omega", 0.1, {"pi", "pi"});
+  Particle::addDecayChannel("electron", 1., {"pi", "pi"});
+  Particle::addDecayChannel("omega", 1., {"pi"});
+
+  ResonanceType four_body{"rho", 0.77526, 0, 0.1491};
+  four_body.addDecayChannel({1., {0, 0, 0, 0}}, 0.);
+  four_body.addDecayChannel({1., {0}}, 0.);
+  std::cout << four_body.getDecayChannels().size() << '\n';
+
+  Particle::getParticleType(Particle{"omega"}.getIndex().value())->print();
+
+  // the default engines of two threads draw different numbers
+  Particle omega{"omega"};
+  Particle thread_products[2][2]{{Particle{"pi"}, Particle{"pi"}},
+                                 {Particle{"pi"}, Particle{"pi"}}};
+
+  for (auto& products : thread_products) {
+    std::thread{[&] { omega.decayToBody(products[0], products[1]); }}.join();
+  }
+
+  std::cout << (thread_products[0][0].getMomentum().x !=
+                thread_products[1][0].getMomentum().x)
+            << '\n';
+
+  DecayEngine decays{};
+  EventBuffer event{};
+  event.push(Particle{"omega", {0.3, -0.2, 1.1}});
+
+  std::cout << decays.isUnstable(event.getTypeId()[0]) << ' '
+            << decays.decay(event, engine) << ' ' << event.size() << '\n';
+
+  double sum[4]{};
+
+  for (int i{1}; i < event.size(); ++i) {
+    sum[0] += event.getPx()[i];
+    sum[1] += event.getPy()[i];
+    sum[2] += event.getPz()[i];
+    sum[3] += event.getEnergy()[i];
+    std::cout << event.getParent()[i] << ' ';
+  }
+
+  std::cout << '\n'
+            << sum[0] << ' ' << sum[1] << ' ' << sum[2] << ' '
+            << std::sqrt(sum[3] * sum[3] - sum[0] * sum[0] - sum[1] * sum[1] -
+                         sum[2] * sum[2])
+            << '\n';
+
+  std::cout << "\n\n"
+            << "TESTING THE \"PairEngine\" CLASS" << '\n';
+
+  EventBuffer pair_event{};
+
+  for (int i{}; i < 300; ++i) {
+    pair_event.push(
+        Particle{"pi", {engine.gaus(), engine.gaus(), engine.gaus()}});
+  }
+
+  PairArrays pair_arrays{pair_event.size(), pair_event.getPx(),
+                         pair_event.getPy(), pair_event.getPz(),
+                         pair_event.getEnergy()};
+  PairEngine pair_engine{64};
+  long long n_pairs{};
+  double max_difference{};
+
+  pair_engine.run(pair_arrays, [&](int i, int j_begin, int n,
+                                   double const* masses) {
+    for (int k{}; k < n; ++k) {
+      double mass = pair_event.getParticle(i).getInvariantMass(
+          pair_event.getParticle(j_begin + k));
+      max_difference = std::max(max_difference, std::abs(masses[k] - mass));
+      ++n_pairs;
+    }
+  });
+
+  std::cout << n_pairs << ' ' << max_difference << '\n';
+
+  struct PairCounter {
+    long long n_pairs;
+
+    void operator()(int, int, int n, double const*) { n_pairs += n; }
+  };
+
+  std::vector<PairCounter> counters(3, PairCounter{0});
+  pair_engine.runParallel(pair_arrays, counters);
+
+  std::cout << counters[0].n_pairs + counters[1].n_pairs + counters[2].n_pairs
+            << '\n';
+
+  std::cout << "\n\n"
+            << "TESTING THE \"EventArena\" CLASS" << '\n';
+
+  EventArena arena{256};
+
+  for (int i{}; i < 2; ++i) {
+    double* doubles = arena.allocate<double>(10);
+    int* ints = arena.allocate<int>(100);
+
+    std::cout << arena.capacity() << ' ' << arena.used() << ' '
+              << reinterpret_cast<std::uintptr_t>(doubles) % 64 << ' '
+              << reinterpret_cast<std::uintptr_t>(ints) % 64 << '\n';
+
+    arena.reset();
+  }
+
+  std::cout << "\n\n"
+            << "TESTING THE CHECKPOINTS" << '\n';
+
+  // the state of a thread is saved after three events and loaded into a new
+  // one. Both then generate a fourth event, which must give the same
+  // histograms
+  CheckpointHeader header{7, 4, 1, 0, 1, 20, 2, false, 0};
+  std::vector<double> px(20), py(20), pz(20), energy(20);
+  std::vector<unsigned> class_masks(20);
+
+  auto next_event = [&](RandomEngine& rng, GenerationHistograms& histograms,
+                        EventMixer& mixer) {
+    for (int i{}; i < 20; ++i) {
+      px[i] = rng.gaus();
+      py[i] = rng.gaus();
+      pz[i] = rng.gaus();
+      energy[i] = std::sqrt(px[i] * px[i] + py[i] * py[i] + pz[i] * pz[i] +
+                            0.13957 * 0.13957);
+      class_masks[i] = i % 2 == 0 ? (POSITIVE | PION) : (NEGATIVE | KAON);
+    }
+
+    static_cast<TH1*>(histograms.histo_list->At(0))->Fill(rng.uniform());
+    histograms.invm_all.fill(rng.uniform());
+    mixer.mix({20, px.data(), py.data(), pz.data(), energy.data()},
+              class_masks.data());
+  };
+
+  RandomEngine saved_rng{7};
+  GenerationHistograms saved_histograms{};
+  saved_histograms.histo_list = new TList();
+  saved_histograms.histo_list->Add(new TH1F("saved_h", "Saved", 10, 0., 1.));
+  EventMixer saved_mixer{saved_histograms, 2};
+
+  for (int i{}; i < 3; ++i) {
+    next_event(saved_rng, saved_histograms, saved_mixer);
+  }
+
+  saved_mixer.drain();
+
+  CheckpointWriter checkpoints{"test_checkpoint", header};
+  checkpoints.save(0, 3, saved_rng, saved_histograms, &saved_mixer);
+  checkpoints.close();
+
+  RandomEngine loaded_rng{1};
+  GenerationHistograms loaded_histograms{};
+  loaded_histograms.histo_list = new TList();
+  loaded_histograms.histo_list->Add(new TH1F("loaded_h", "Loaded", 10, 0., 1.));
+  EventMixer loaded_mixer{loaded_histograms, 2};
+  CheckpointHeader other_header{header};
+  other_header.seed = 8;
+
+  // a checkpoint of a different run and a missing one
+  std::cout << loadCheckpoint("test_checkpoint", header, 0, loaded_rng,
+                              loaded_histograms, &loaded_mixer)
+            << ' '
+            << loadCheckpoint("test_checkpoint", other_header, 0, loaded_rng,
+                              loaded_histograms, nullptr)
+            << ' '
+            << loadCheckpoint("test_checkpoint", header, 1, loaded_rng,
+                              loaded_histograms, nullptr)
+            << '\n';
+
+  next_event(saved_rng, saved_histograms, saved_mixer);
+  next_event(loaded_rng, loaded_histograms, loaded_mixer);
+  saved_mixer.close();
+  loaded_mixer.close();
+
+  auto saved_h = static_cast<TH1*>(saved_histograms.histo_list->At(0));
+  auto loaded_h = static_cast<TH1*>(loaded_histograms.histo_list->At(0));
+  bool same_histograms = saved_h->GetEntries() == loaded_h->GetEntries();
+
+  for (int bin{}; bin < saved_h->GetNbinsX() + 2; ++bin) {
+    same_histograms = same_histograms && saved_h->GetBinContent(bin) ==
+                                             loaded_h->GetBinContent(bin);
+  }
+
+  auto const& saved_mixed = saved_histograms.invm_mixed_opposite_charge;
+  auto const& loaded_mixed = loaded_histograms.invm_mixed_opposite_charge;
+
+  for (int bin{}; bin < InvariantMassAxis::n_bins + 2; ++bin) {
+    same_histograms = same_histograms &&
+                      saved_histograms.invm_all.getBinContent(bin) ==
+                          loaded_histograms.invm_all.getBinContent(bin) &&
+                      saved_mixed.getBinContent(bin) ==
+                          loaded_mixed.getBinContent(bin);
+  }
+
+  std::cout << (saved_rng() == loaded_rng()) << ' ' << same_histograms << ' '
+            << saved_mixed.getEntries() << ' ' << loaded_mixed.getEntries()
+            << '\n';
+
+  removeCheckpoints("test_checkpoint", 1);
 }